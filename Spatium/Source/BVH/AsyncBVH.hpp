@@ -0,0 +1,72 @@
+#ifndef ASYNC_BVH_HPP
+#define ASYNC_BVH_HPP
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+
+#include "BVH.hpp"
+
+namespace Spatium
+{
+	// Stands in for an object inside an AsyncBVH's trees. Every tree gets its own proxies, so its bounds are a snapshot that neither the live
+	// objects nor the next tree being built can change underneath readers.
+	template <typename T>
+	struct AsyncBVHProxy
+	{
+		T m_Object;
+		AABB m_AABB; // The object's bounds at the time of the snapshot.
+	};
+
+	// Double buffered BVH. Rebuilds run top down on a background thread from a snapshot of object bounds, while queries carry on against the
+	// current tree. A finished tree is swapped in by Publish(), typically at the start of a frame, and the previous tree is destroyed once the
+	// last reader still holding it lets go. The traits are only used to read the objects' bounds while taking a snapshot.
+	template <typename T, typename Traits = BVHDefaultTraits<T>>
+	class AsyncBVH
+	{
+	public:
+		using Proxy = AsyncBVHProxy<T>;
+
+		struct Snapshot
+		{
+			std::vector<Proxy> m_Proxies;
+			BVH<Proxy*> m_BVH;
+		};
+
+	public:
+		AsyncBVH(const BVHBuildConfiguration& buildConfiguration, const Traits& traits = Traits());
+		~AsyncBVH(); // Waits for any rebuild in flight.
+
+		AsyncBVH(const AsyncBVH&) = delete;
+		AsyncBVH& operator=(const AsyncBVH&) = delete;
+
+		// Copies the objects' bounds on the calling thread and builds from the copy in the background. Returns false without doing anything if a
+		// rebuild is already in flight.
+		template <typename Iterator>
+		bool BeginRebuild(Iterator itBegin, Iterator itEnd);
+
+		bool Publish(); // Swaps in the rebuilt tree if it has finished. Returns true if it was swapped in.
+		void WaitForRebuild(); // Blocks until the rebuild in flight has finished, after which Publish() always succeeds.
+		bool IsRebuilding() const;
+
+		// Readers hold on to the snapshot for as long as they query it, which keeps it alive across a Publish(). Objects show up as proxies,
+		// with the object itself in m_Object. Returns nullptr until the first tree has been published.
+		std::shared_ptr<const Snapshot> Acquire() const;
+
+	private:
+		BVHBuildConfiguration m_BuildConfiguration;
+		Traits m_Traits;
+
+		std::shared_ptr<const Snapshot> m_CurrentSnapshot; // Only ever accessed through the std::atomic_load/store overloads for shared_ptr.
+		std::shared_ptr<Snapshot> m_PendingSnapshot; // Owned by the worker until m_IsRebuildFinished is set.
+
+		std::thread m_Worker;
+		std::atomic<bool> m_IsRebuildFinished = { false };
+	};
+}
+
+#include "AsyncBVH.inl"
+
+#endif
@@ -0,0 +1,97 @@
+#include "AsyncBVH.hpp"
+#include <iterator>
+
+namespace Spatium
+{
+    template <typename T, typename Traits>
+    AsyncBVH<T, Traits>::AsyncBVH(const BVHBuildConfiguration& buildConfiguration, const Traits& traits) : m_BuildConfiguration(buildConfiguration), m_Traits(traits)
+    {
+
+    }
+
+    template <typename T, typename Traits>
+    AsyncBVH<T, Traits>::~AsyncBVH()
+    {
+        WaitForRebuild();
+    }
+
+    template <typename T, typename Traits>
+    template <typename Iterator>
+    bool AsyncBVH<T, Traits>::BeginRebuild(Iterator itBegin, Iterator itEnd)
+    {
+        if (IsRebuilding())
+        {
+            return false;
+        }
+
+        // A finished but unpublished tree is simply replaced.
+        WaitForRebuild();
+
+        std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+        snapshot->m_Proxies.reserve(std::distance(itBegin, itEnd));
+        for (Iterator it = itBegin; it != itEnd; ++it)
+        {
+            Proxy proxy;
+            proxy.m_Object = *it;
+            proxy.m_AABB = m_Traits.GetAABB(*it);
+            snapshot->m_Proxies.push_back(proxy);
+        }
+
+        m_PendingSnapshot = snapshot;
+        m_IsRebuildFinished.store(false, std::memory_order_relaxed);
+
+        m_Worker = std::thread([this, snapshot]()
+        {
+            // The proxies never move again once the vector is filled in, so they can be handed to the tree by address.
+            std::vector<Proxy*> proxyPointers;
+            proxyPointers.reserve(snapshot->m_Proxies.size());
+            for (Proxy& proxy : snapshot->m_Proxies)
+            {
+                proxyPointers.push_back(&proxy);
+            }
+
+            snapshot->m_BVH.BuildTopDown(proxyPointers.begin(), proxyPointers.end(), m_BuildConfiguration);
+            m_IsRebuildFinished.store(true, std::memory_order_release);
+        });
+
+        return true;
+    }
+
+    template <typename T, typename Traits>
+    bool AsyncBVH<T, Traits>::Publish()
+    {
+        if (IsRebuilding() || m_PendingSnapshot == nullptr)
+        {
+            return false;
+        }
+
+        WaitForRebuild();
+
+        // Readers that acquired the previous tree keep it alive until they are done with it.
+        std::atomic_store_explicit(&m_CurrentSnapshot, std::shared_ptr<const Snapshot>(std::move(m_PendingSnapshot)), std::memory_order_release);
+        m_PendingSnapshot = nullptr;
+
+        return true;
+    }
+
+    template <typename T, typename Traits>
+    void AsyncBVH<T, Traits>::WaitForRebuild()
+    {
+        if (m_Worker.joinable())
+        {
+            m_Worker.join();
+        }
+    }
+
+    template <typename T, typename Traits>
+    bool AsyncBVH<T, Traits>::IsRebuilding() const
+    {
+        return m_Worker.joinable() && !m_IsRebuildFinished.load(std::memory_order_acquire);
+    }
+
+    template <typename T, typename Traits>
+    std::shared_ptr<const typename AsyncBVH<T, Traits>::Snapshot> AsyncBVH<T, Traits>::Acquire() const
+    {
+        return std::atomic_load_explicit(&m_CurrentSnapshot, std::memory_order_acquire);
+    }
+}
@@ -5,22 +5,99 @@
 #include <vector>
 #include <limits>
 #include <functional>
+#include <memory>
+#include <utility>
+#include <type_traits>
 
 #include "Core/Core.h"
 #include "Core/Geometry.h"
+#include "Core/RayPacket.h"
+#include "Core/Morton.h"
+#include "Core/ThreadPool.h"
+#include "Core/ObjectPool.h"
+#include "Core/TraversalStack.h"
+#include "Core/PriorityQueue.h"
 
 namespace Spatium
 {
+	enum class BVHTopDownStrategy
+	{
+		KSplitPoints, // Sorts along each axis and samples K split points per node.
+		BinnedSAH,    // Bins object centroids along each axis and sweeps the bins for the cheapest split.
+		FullSweepSAH  // Sorts centroids along each axis once up front and evaluates the SAH at every split. The slowest and best, for baking static scenes.
+	};
+
+	enum class BVHBottomUpStrategy
+	{
+		BestPairMerge,           // Repeatedly merges the globally cheapest pair of nodes.
+		LocallyOrderedClustering // Morton orders the leaves and merges mutual nearest neighbours found within a small window (PLOC).
+	};
+
+	enum class BVHInsertionStrategy
+	{
+		GreedyVolume,     // Descends towards the child whose volume grows the least, stopping at the first local minimum.
+		BranchAndBoundSAH // Searches the whole tree for the sibling with the lowest surface area cost, including the growth of every ancestor.
+	};
+
 	struct BVHBuildConfiguration
 	{
 		uint32_t m_MaxDepth = std::numeric_limits<uint32_t>::max();
 		uint32_t m_MinimumObjects = 20; // Nodes should have more than this amount of objects to be split.
 		float m_MinimumVolume = 250.0f; // Nodes with smaller volume than this will not be split.
 
+		BVHTopDownStrategy m_TopDownStrategy = BVHTopDownStrategy::KSplitPoints;
 		const int m_TopDownKSplitPoints = 16;
+		uint32_t m_TopDownBinCount = 16; // Centroid bins per axis for the binned SAH strategy.
+		BVHBottomUpStrategy m_BottomUpStrategy = BVHBottomUpStrategy::BestPairMerge;
+		uint32_t m_ClusteringSearchRadius = 16; // Neighbours searched on either side of each cluster when clustering locally.
+		uint32_t m_MortonCodeBits = 30; // Linear builds quantize object centers into 30-bit (10 per axis) or 63-bit (21 per axis) Morton codes.
+
+		uint32_t m_ThreadCount = 1; // Threads used during builds, including the calling thread. 0 uses all hardware threads.
+		uint32_t m_ParallelGrainSize = 4096; // Object ranges smaller than this are processed serially.
+
+		BVHInsertionStrategy m_InsertionStrategy = BVHInsertionStrategy::GreedyVolume; // Also decides whether rotations after insertions weigh volume or surface area.
+		float m_UpdateMargin = 0.1f; // Objects reinserted by Update() get their box fattened by this much on every side...
+		float m_UpdateDisplacementMultiplier = 2.0f; // ...and extruded along this many frames worth of their displacement.
+	};
+
+	struct BVHOptimizationConfiguration
+	{
+		uint32_t m_TreeletLeafCount = 7; // Leaves per treelet when restructuring. The search grows as 3^n, so keep this small.
+		uint32_t m_TreeletIterations = 3; // Each pass only visits nodes with at least twice as many leaves below them as the previous one.
+
+		uint32_t m_ReinsertionIterations = 8; // Upper bound on reinsertion passes. Passes stop early once they no longer pay off.
+		float m_ReinsertionBatchFraction = 0.01f; // Fraction of nodes reinserted per pass, most inefficient first (Bittner: surface area weighted by how much smaller the children are).
+		float m_ReinsertionTimeBudget = 0.0f; // In milliseconds. 0 means no limit.
+
+		uint32_t m_ThreadCount = 1; // Threads used during optimization, including the calling thread. 0 uses all hardware threads.
 	};
 
+	template <typename T, typename = void>
+	struct HasBVHHook : std::false_type { };
+
+	template <typename T>
+	struct HasBVHHook<T, std::void_t<decltype(std::declval<T>()->m_BVHInfo.m_Node)>> : std::true_type { };
+
+	// Tells the tree how to get at an object's bounds and where to keep the leaf holding it. The defaults work on pointers to objects with an
+	// m_AABB, optionally carrying an m_BVHInfo.m_Node hook. Custom traits provide the same members, so that plain handles such as indices into
+	// a component array can be stored directly, with their bounds looked up wherever they live. Traits may hold state and are copied into the tree.
 	template <typename T>
+	struct BVHDefaultTraits
+	{
+		// Only Remove() and Update() need to find an object's leaf. Traits without node storage can leave out GetNode() and SetNode().
+		static constexpr bool s_HasNodeStorage = HasBVHHook<T>::value;
+
+		const AABB& GetAABB(const T& targetObject) const { return targetObject->m_AABB; }
+		void SetAABB(const T& targetObject, const AABB& newAABB) const { targetObject->m_AABB = newAABB; } // Only needed by Update().
+		T GetNullObject() const { return nullptr; } // Returned by queries that find nothing.
+
+		template <typename Node>
+		Node* GetNode(const T& targetObject) const { return targetObject->m_BVHInfo.m_Node; }
+		template <typename Node>
+		void SetNode(const T& targetObject, Node* leafNode) const { targetObject->m_BVHInfo.m_Node = leafNode; }
+	};
+
+	template <typename T, typename Traits = BVHDefaultTraits<T>>
 	class BVH
 	{
 	public:
@@ -29,8 +106,6 @@ namespace Spatium
 		public:
 			BVHNode();
 
-			void AddObject(T targetObject); // Only Leaf Nodes
-
 			int GetDepth() const;
 			int GetSize() const; // Node Count
 			bool IsLeaf() const;
@@ -39,12 +114,9 @@ namespace Spatium
 			template <typename Function>
 			void TraverseLevelOrder(Function traversalFunction) const; // Applies the function to all nodes within this node's subtree.
 
-			template <typename Function>
-			void TraverseLevelOrderObjects(Function traversalFunction) const; // Applies the function to all objects within this node's subtree.
-
-			// Linked list of objects within this node.
-			T m_FirstObject;
-			T m_LastObject;
+			// Leafs own a contiguous range of the tree's objects (see BVH::GetObjects()).
+			uint32_t m_FirstObject;
+			uint32_t m_ObjectCount;
 			
 			AABB m_AABB;
 			BVHNode* m_Children[2];
@@ -53,6 +125,7 @@ namespace Spatium
 
 	public:
 		BVH();
+		explicit BVH(const Traits& traits);
 		~BVH();
 
 		template <typename Iterator>
@@ -61,10 +134,27 @@ namespace Spatium
 		template <typename Iterator>
 		void BuildBottomUp(Iterator itBegin, Iterator itEnd, const BVHBuildConfiguration& buildConfiguration);
 
+		template <typename Iterator>
+		void BuildLinear(Iterator itBegin, Iterator itEnd, const BVHBuildConfiguration& buildConfiguration);
+
 		template <typename Iterator>
 		void Insert(Iterator itBegin, Iterator itEnd, const BVHBuildConfiguration& buildConfiguration);
 
 		void Insert(T targetObject, const BVHBuildConfiguration& buildConfiguration);
+		bool Remove(T targetObject); // Returns false if the object isn't in the tree.
+
+		// Moves the object to its new box. Objects are only reinserted once they leave their leaf's box, in which case they are given a fattened
+		// box extruded along their displacement over the last frame, so that small movements over the next few frames cost nothing. Returns true
+		// when the object was reinserted.
+		bool Update(T targetObject, const AABB& newAABB, const glm::vec3& displacement, const BVHBuildConfiguration& buildConfiguration);
+
+		// Recomputes every node's box from the current object bounds, keeping the topology. Returns the SAH cost relative to the last build or
+		// optimization, which creeps up as objects move away from where the tree was built for. Rebuild once it grows too large. Trees built only
+		// through Insert() take their first refit as the baseline, which therefore returns 1.
+		float Refit(uint32_t threadCount = 1); // 0 uses all hardware threads.
+
+		void OptimizeTreelets(const BVHOptimizationConfiguration& optimizationConfiguration); // Rewrites small treelets into their lowest SAH cost topology.
+		void OptimizeReinsertion(const BVHOptimizationConfiguration& optimizationConfiguration); // Moves costly subtrees to wherever they add the least SAH cost.
 
 		template <typename Function> 
 		void TraverseLevelOrder(Function traversalFunction) const;
@@ -72,6 +162,47 @@ namespace Spatium
 		template <typename Function> 
 		void TraverseLevelOrderObjects(Function func) const;
 
+		// Ray queries take an intersectionFunction(T object, float& hitDistance) that tests the object itself. It should return true and lower
+		// hitDistance for hits closer than hitDistance, and return false otherwise.
+		template <typename Function>
+		T IntersectClosest(const Ray& ray, float& hitDistance, Function intersectionFunction) const; // Returns the closest object hit within hitDistance, or the null object (see BVHDefaultTraits).
+
+		template <typename Function>
+		bool IntersectAny(const Ray& ray, float maximumDistance, Function intersectionFunction) const; // Stops at the first hit, for occlusion and line of sight tests.
+
+		template <typename Function>
+		void Query(const AABB& queryAABB, Function queryFunction) const; // Applies the function to all objects whose bounding box overlaps the given one.
+
+		template <typename Function>
+		void QueryFrustum(const Frustum& frustum, Function queryFunction) const; // Applies the function to all objects whose bounding box is at least partially inside the frustum.
+
+		template <typename Function>
+		void QueryOverlappingPairs(Function pairFunction) const; // Calls pairFunction(T, T) once for every pair of objects whose bounding boxes overlap.
+		void FindOverlappingPairs(std::vector<std::pair<T, T>>& overlappingPairs, uint32_t threadCount = 1) const; // Same pairs, found in parallel. 0 uses all hardware threads.
+
+		// Pairs each object in this tree with every object in the other tree whose bounding box it overlaps, calling pairFunction(T, U). The transform
+		// optionally maps the other tree into this tree's space. Returning false from the function stops the query, in which case this returns false.
+		template <typename U, typename OtherTraits, typename Function>
+		bool QueryOverlappingPairs(const BVH<U, OtherTraits>& otherBVH, Function pairFunction) const;
+		template <typename U, typename OtherTraits, typename Function>
+		bool QueryOverlappingPairs(const BVH<U, OtherTraits>& otherBVH, const glm::mat4& otherToThisTransform, Function pairFunction) const;
+
+		// Nearest queries take a distanceFunction(T object, const glm::vec3& point) that returns the squared distance from the point to the object itself.
+		// Objects further than the given squared distance away are ignored.
+		template <typename Function>
+		T FindNearest(const glm::vec3& point, Function distanceFunction, float maximumSquaredDistance = std::numeric_limits<float>::max()) const; // The null object if nothing is in range.
+		template <typename Function>
+		void FindKNearest(const glm::vec3& point, uint32_t neighbourCount, std::vector<T>& nearestObjects, Function distanceFunction, float maximumSquaredDistance = std::numeric_limits<float>::max()) const; // Nearest first.
+
+		// Packet versions trace coherent rays together, testing each node against all of the packet's rays still active within it at once. Their
+		// intersectionFunction also receives the ray's index within the packet, as in (T object, uint32_t rayIndex, float& hitDistance). Once fewer
+		// than singleRayFraction of the packet's rays reach a subtree, those rays finish it one at a time.
+		template <uint32_t PacketSize, typename Function>
+		void IntersectClosest(const RayPacket<PacketSize>& rayPacket, float* hitDistances, T* hitObjects, Function intersectionFunction, float singleRayFraction = 0.25f) const;
+
+		template <uint32_t PacketSize, typename Function>
+		uint32_t IntersectAny(const RayPacket<PacketSize>& rayPacket, const float* maximumDistances, Function intersectionFunction, float singleRayFraction = 0.25f) const; // Returns a mask of the rays that hit.
+
 		void Clear();
 
 		bool IsEmpty() const;
@@ -79,23 +210,99 @@ namespace Spatium
 		int GetSize() const;
 		const BVHNode* GetRoot() const;
 		uint32_t GetObjectCount() const { return m_ObjectCount; }
+		const Traits& GetTraits() const { return m_Traits; }
+		const std::vector<T>& GetObjects() const { return m_Objects; } // In leaf order. Entries outside of every leaf's range are left over from removals.
+		float ComputeSAHCost() const; // Expected traversal cost of the tree, relative to the root's surface area.
 
 	private:
-		BVHNode* BuildTopDownRecursive(std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex, const BVHBuildConfiguration& buildConfiguration, uint32_t currentDepth);
-		AABB CreateEncapsulatingBoundingVolume(const std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex);
+		BVHNode* BuildTopDownRecursive(std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex, const BVHBuildConfiguration& buildConfiguration, uint32_t currentDepth, ThreadPool* threadPool);
+		AABB CreateEncapsulatingBoundingVolume(const std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex, ThreadPool* threadPool, size_t grainSize);
 		size_t PartitionObjects(std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex, const BVHBuildConfiguration& buildConfiguration);
+		size_t PartitionObjectsBinned(std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex, const BVHBuildConfiguration& buildConfiguration, ThreadPool* threadPool);
+		template <typename Predicate>
+		size_t PartitionRange(std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex, Predicate isLeft, ThreadPool* threadPool, size_t grainSize);
+
+		// The full sweep build keeps the objects' indices sorted along each axis, with every node owning the same range in all three lists.
+		struct SweepBuildState
+		{
+			std::vector<T> m_SourceObjects;
+			std::vector<uint32_t> m_SortedIndices[3];
+			std::vector<uint8_t> m_IsLeft; // Per object. Set by the split axis, then read to partition the other two lists.
+			std::vector<uint32_t> m_ScratchIndices;
+			std::vector<float> m_RightAreas; // Surface area of everything right of each split during a sweep.
+		};
+
+		BVHNode* BuildTopDownSweep(const BVHBuildConfiguration& buildConfiguration, ThreadPool* threadPool);
+		BVHNode* BuildTopDownSweepRecursive(SweepBuildState& buildState, size_t beginIndex, size_t endIndex, const BVHBuildConfiguration& buildConfiguration, uint32_t currentDepth, ThreadPool* threadPool);
+		size_t PartitionObjectsSweep(SweepBuildState& buildState, size_t beginIndex, size_t endIndex);
+
+		template <typename Function>
+		T IntersectClosestFrom(const BVHNode* startNode, const Ray& ray, float& hitDistance, Function intersectionFunction) const;
+		template <typename Function>
+		bool IntersectAnyFrom(const BVHNode* startNode, const Ray& ray, float maximumDistance, Function intersectionFunction) const;
+		static uint32_t CountActiveRays(uint32_t activeMask);
+
+		template <typename Function>
+		void ForEachSubtreeObject(const BVHNode* subtreeRoot, Function objectFunction) const;
+		template <typename Function>
+		void ForEachLeafObject(const BVHNode* leafNode, Function objectFunction) const; // Stops early once the function returns false.
+
+		void AssignLeafObjects(BVHNode* leafNode, uint32_t firstObject, uint32_t objectCount); // Hands a range of m_Objects to an empty leaf and grows it to fit.
+		void AppendLeafObject(BVHNode* leafNode, T targetObject); // Moves the leaf's range to the end of m_Objects first unless it already sits there.
+		void CompactObjects(); // Drops the entries left over from removals and moved ranges.
+		void SetObjectNode(T targetObject, BVHNode* leafNode) const;
+
+		template <typename Function>
+		void SearchNearest(const glm::vec3& point, uint32_t neighbourCount, float maximumSquaredDistance, Function distanceFunction, PriorityQueue<std::pair<float, T>>& nearestObjects) const;
+		template <typename U, typename OtherTraits, typename Function>
+		bool CollectTreePairs(const BVH<U, OtherTraits>& otherBVH, const glm::mat4* otherToThisTransform, Function pairFunction) const;
+		template <typename Function>
+		void CollectOverlappingPairs(const BVHNode* nodeA, const BVHNode* nodeB, Function pairFunction) const; // Passing the same node twice finds the pairs within it.
+
+		ThreadPool* AcquireThreadPool(uint32_t threadCount) const; // Returns nullptr when running single threaded. 0 uses all hardware threads.
+
+		struct MortonPrimitive
+		{
+			uint64_t m_Code;
+			uint32_t m_ObjectIndex;
+		};
+
+		void ComputeMortonCodes(const std::vector<T>& targetObjects, std::vector<MortonPrimitive>& mortonPrimitives, uint32_t mortonCodeBits, ThreadPool* threadPool, size_t grainSize);
+		void SortMortonCodes(std::vector<MortonPrimitive>& mortonPrimitives, uint32_t mortonCodeBits);
+		BVHNode* BuildLinearHierarchy(const std::vector<T>& targetObjects, const std::vector<MortonPrimitive>& mortonPrimitives, const BVHBuildConfiguration& buildConfiguration, ThreadPool* threadPool);
+
+		BVHNode* BuildLocallyOrderedClusters(const std::vector<T>& targetObjects, const BVHBuildConfiguration& buildConfiguration, ThreadPool* threadPool);
 
 		BVHNode* FindBestMergeCandidate(BVHNode* node, const std::vector<BVHNode*>& nodes);
 		BVHNode* BuildBottomUpIterative(std::vector<BVHNode*>& objectNodes);
 		BVHNode* CreateParentNode(BVHNode* leftNode, BVHNode* rightNode);
 		float ComputeBestPairCost(BVHNode* node, const std::vector<BVHNode*>& nodes);
 
-		BVHNode* FindBestSibling(T newObject);
-		void RotateRebalance(BVHNode* node);
+		bool RestructureTreelet(BVHNode* treeletRoot, uint32_t treeletLeafCount);
+		BVHNode* DetachSubtree(BVHNode* node); // Unlinks the node and its parent, returning the parent for reuse.
+		void AttachSubtree(BVHNode* node, BVHNode* siblingNode, BVHNode* parentNode); // Links the node in as the sibling's sibling, under parentNode.
+		BVHNode* FindBestSiblingSAH(const AABB& aabb) const;
+		void RefitAncestors(BVHNode* node);
+		double RefitSubtree(BVHNode* subtreeRoot); // Returns the subtree's unnormalized SAH cost.
+
+		void InsertObject(T targetObject, const AABB& insertionAABB, const BVHBuildConfiguration& buildConfiguration); // Leaves are grown to fit the insertion box.
+		BVHNode* FindBestSibling(const AABB& newAABB);
+		void RotateRebalance(BVHNode* node, BVHInsertionStrategy insertionStrategy);
 
 	private:
+		template <typename U, typename OtherTraits>
+		friend class BVH; // Tree versus tree queries walk the other tree's leafs.
+
+		Traits m_Traits;
 		BVHNode* m_Root;
 		uint32_t m_ObjectCount;
+		float m_LastBuildSAHCost = 0.0f;
+
+		std::vector<T> m_Objects; // Every leaf's objects, one contiguous range per leaf.
+		size_t m_StaleObjectCount = 0; // Entries no longer covered by any leaf. Compacted away once they outnumber the live ones.
+		ObjectPool<BVHNode> m_NodePool; // Owns every node. Rebuilds reuse the previous tree's memory.
+
+		mutable std::unique_ptr<ThreadPool> m_ThreadPool; // Created on the first parallel build or query and kept around for the next.
 	};
 }
 
@@ -2,110 +2,119 @@
 #define BVH_INL
 
 #include <queue>
+#include <deque>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
 
 #include "BVH.hpp"
 
 namespace Spatium
 {
-    template <typename T>
-    BVH<T>::BVH() : m_Root(nullptr), m_ObjectCount(0)
+    template <typename T, typename Traits>
+    BVH<T, Traits>::BVH() : BVH(Traits())
     {
 
     }
 
-    template <typename T>
-    BVH<T>::~BVH()
+    template <typename T, typename Traits>
+    BVH<T, Traits>::BVH(const Traits& traits) : m_Traits(traits), m_Root(nullptr), m_ObjectCount(0)
+    {
+
+    }
+
+    template <typename T, typename Traits>
+    BVH<T, Traits>::~BVH()
     {
         Clear();
     }
 
-    template <typename T>
-    void BVH<T>::Clear()
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::Clear()
     {
         if (m_Root != nullptr)
         {
-            // Recursively delete nodes starting from the root.
-            std::function<void(BVHNode*)> DeleteNodes = [&](BVHNode* node)
+            // Nodes all live in the pool, so objects only need visiting when the traits store their node.
+            if constexpr (Traits::s_HasNodeStorage)
             {
-                if (node != nullptr)
-                {
-                    // Leafs contain objects.
-                    if (node->IsLeaf())
-                    {
-                        // Delete all objects in the linked list and reset their bvhInfo accordingly.
-                        T currentObject = node->m_FirstObject;
-                        while (currentObject != nullptr)
-                        {
-                            T nextObject = currentObject->m_BVHInfo.m_Next;
-                            currentObject->m_BVHInfo.m_Next = nullptr;
-                            currentObject->m_BVHInfo.m_Previous = nullptr;
-                            currentObject->m_BVHInfo.m_Node = nullptr;
-                            currentObject = nextObject;
-                        }
-                    }
-                    else // Otherwise, recursively delete children.
-                    {
-                        DeleteNodes(node->m_Children[0]);
-                        DeleteNodes(node->m_Children[1]);
-                    }
-
-                    // Finally, delete the node itself.
-                    delete node;
-                }
-            };
-
-            // Start deletion from the root itself.
-            DeleteNodes(m_Root);
+                ForEachSubtreeObject(m_Root, [this](T currentObject) { SetObjectNode(currentObject, nullptr); });
+            }
 
-            // Reset the BVH state.
+            // Reset the BVH state. The pool keeps its memory around for the next build.
+            m_NodePool.Reset();
             m_Root = nullptr;
             m_ObjectCount = 0;
+            m_LastBuildSAHCost = 0.0f;
         }
+
+        m_Objects.clear();
+        m_StaleObjectCount = 0;
     }
 
-    template <typename T>
+    template <typename T, typename Traits>
     template <typename Iterator>
-    void BVH<T>::BuildTopDown(Iterator itBegin, Iterator itEnd, const BVHBuildConfiguration& buildConfiguration)
+    void BVH<T, Traits>::BuildTopDown(Iterator itBegin, Iterator itEnd, const BVHBuildConfiguration& buildConfiguration)
     {
         Clear();
-        std::vector<T> sceneObjects(itBegin, itEnd);
-        m_ObjectCount = (uint32_t)sceneObjects.size();
-        m_Root = BuildTopDownRecursive(sceneObjects, 0, sceneObjects.size(), buildConfiguration, 0);
+
+        // Partitioning sorts the objects in place, which leaves every leaf's objects next to each other.
+        m_Objects.assign(itBegin, itEnd);
+        m_ObjectCount = (uint32_t)m_Objects.size();
+        m_Root = buildConfiguration.m_TopDownStrategy == BVHTopDownStrategy::FullSweepSAH ? BuildTopDownSweep(buildConfiguration, AcquireThreadPool(buildConfiguration.m_ThreadCount))
+                                                                                         : BuildTopDownRecursive(m_Objects, 0, m_Objects.size(), buildConfiguration, 0, AcquireThreadPool(buildConfiguration.m_ThreadCount));
+        m_LastBuildSAHCost = ComputeSAHCost();
     }
 
-    template <typename T>
-    typename BVH<T>::BVHNode* BVH<T>::BuildTopDownRecursive(std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex, const BVHBuildConfiguration& buildConfiguration, uint32_t currentDepth)
+    template <typename T, typename Traits>
+    typename BVH<T, Traits>::BVHNode* BVH<T, Traits>::BuildTopDownRecursive(std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex, const BVHBuildConfiguration& buildConfiguration, uint32_t currentDepth, ThreadPool* threadPool)
     {
         if (beginIndex >= endIndex)
         {
             return nullptr;
         }
 
-        BVHNode* node = new BVHNode();
-        node->m_AABB = CreateEncapsulatingBoundingVolume(targetObjects, beginIndex, endIndex);
+        BVHNode* node = m_NodePool.Allocate();
+        node->m_AABB = CreateEncapsulatingBoundingVolume(targetObjects, beginIndex, endIndex, threadPool, buildConfiguration.m_ParallelGrainSize);
 
         // Add objects to leaf if any of the following conditions are met.
         if (currentDepth >= buildConfiguration.m_MaxDepth || (endIndex - beginIndex) <= buildConfiguration.m_MinimumObjects || node->m_AABB.GetVolume() <= buildConfiguration.m_MinimumVolume)
         {
-            for (size_t i = beginIndex; i < endIndex; i++)
-            {
-                node->AddObject(targetObjects[i]);
-            }
-
+            AssignLeafObjects(node, (uint32_t)beginIndex, (uint32_t)(endIndex - beginIndex));
             return node;
         }
 
-        // Otherwise, proceed to split. We will use the K-Splits Points approach here.
-        size_t bestSplitPoint = PartitionObjects(targetObjects, beginIndex, endIndex, buildConfiguration);
+        // Otherwise, proceed to split using the configured strategy.
+        size_t bestSplitPoint = buildConfiguration.m_TopDownStrategy == BVHTopDownStrategy::BinnedSAH ? PartitionObjectsBinned(targetObjects, beginIndex, endIndex, buildConfiguration, threadPool)
+                                                                                                      : PartitionObjects(targetObjects, beginIndex, endIndex, buildConfiguration);
 
-        node->m_Children[0] = BuildTopDownRecursive(targetObjects, beginIndex, bestSplitPoint, buildConfiguration, currentDepth + 1);
-        node->m_Children[1] = BuildTopDownRecursive(targetObjects, bestSplitPoint, endIndex, buildConfiguration, currentDepth + 1);
+        // Both halves touch disjoint ranges of the object list, so large ones can be built concurrently. Small ones are not worth the task overhead.
+        if (threadPool != nullptr && (endIndex - beginIndex) >= buildConfiguration.m_ParallelGrainSize)
+        {
+            std::future<void> leftBuild = threadPool->Submit([&, beginIndex, bestSplitPoint, currentDepth]()
+            {
+                node->m_Children[0] = BuildTopDownRecursive(targetObjects, beginIndex, bestSplitPoint, buildConfiguration, currentDepth + 1, threadPool);
+            });
+            node->m_Children[1] = BuildTopDownRecursive(targetObjects, bestSplitPoint, endIndex, buildConfiguration, currentDepth + 1, threadPool);
+            threadPool->Wait(leftBuild);
+        }
+        else
+        {
+            node->m_Children[0] = BuildTopDownRecursive(targetObjects, beginIndex, bestSplitPoint, buildConfiguration, currentDepth + 1, nullptr);
+            node->m_Children[1] = BuildTopDownRecursive(targetObjects, bestSplitPoint, endIndex, buildConfiguration, currentDepth + 1, nullptr);
+        }
+        for (BVHNode* childNode : node->m_Children)
+        {
+            if (childNode != nullptr)
+            {
+                childNode->m_Parent = node;
+            }
+        }
 
         return node;
     }
 
-    template <typename T>
-    size_t BVH<T>::PartitionObjects(std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex, const BVHBuildConfiguration& buildConfiguration)
+    template <typename T, typename Traits>
+    size_t BVH<T, Traits>::PartitionObjects(std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex, const BVHBuildConfiguration& buildConfiguration)
     {
         // Choose the best split based on Surface Area Heuristics.
         const size_t kSplitPoints = buildConfiguration.m_TopDownKSplitPoints;
@@ -118,9 +127,9 @@ namespace Spatium
         for (int axis = 0; axis < 3; axis++)
         {
             // Sorts objects along each axis based on the center of their bounding volumes.
-            std::sort(targetObjects.begin() + beginIndex, targetObjects.begin() + endIndex, [axis](const T& a, const T& b)
+            std::sort(targetObjects.begin() + beginIndex, targetObjects.begin() + endIndex, [this, axis](const T& a, const T& b)
             {
-                return a->m_AABB.GetCenter()[axis] < b->m_AABB.GetCenter()[axis];
+                return m_Traits.GetAABB(a).GetCenter()[axis] < m_Traits.GetAABB(b).GetCenter()[axis];
             });
 
             std::vector<AABB> leftBounds(kSplitPoints);
@@ -133,8 +142,8 @@ namespace Spatium
                 size_t middleIndex = beginIndex + (endIndex - beginIndex) * i / kSplitPoints;
 
                 // Create a bounding volume for all objects to its left and right respectively.
-                leftBounds[i] = CreateEncapsulatingBoundingVolume(targetObjects, beginIndex, middleIndex);
-                rightBounds[i] = CreateEncapsulatingBoundingVolume(targetObjects, middleIndex, endIndex);
+                leftBounds[i] = CreateEncapsulatingBoundingVolume(targetObjects, beginIndex, middleIndex, nullptr, 0);
+                rightBounds[i] = CreateEncapsulatingBoundingVolume(targetObjects, middleIndex, endIndex, nullptr, 0);
 
                 // Obtain SA for these two bounding volumes.
                 float leftSurfaceArea = leftBounds[i].GetSurfaceArea();
@@ -156,40 +165,436 @@ namespace Spatium
         // Once we're done, we do a final sort of the objects based on the best axis to ensure that subsequent operations use the found split position correctly.
         if (bestAxis != -1)
         {
-            std::sort(targetObjects.begin() + beginIndex, targetObjects.begin() + endIndex, [bestAxis](const T& a, const T& b)
+            std::sort(targetObjects.begin() + beginIndex, targetObjects.begin() + endIndex, [this, bestAxis](const T& a, const T& b)
             {
-                return a->m_AABB.GetCenter()[bestAxis] < b->m_AABB.GetCenter()[bestAxis];
+                return m_Traits.GetAABB(a).GetCenter()[bestAxis] < m_Traits.GetAABB(b).GetCenter()[bestAxis];
             });
         }
 
         return bestSplitPoint;
     }
 
-    template <typename T>
-    template <typename Iterator>
-    void BVH<T>::BuildBottomUp(Iterator itBegin, Iterator itEnd, const BVHBuildConfiguration& buildConfiguration)
+    template <typename T, typename Traits>
+    size_t BVH<T, Traits>::PartitionObjectsBinned(std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex, const BVHBuildConfiguration& buildConfiguration, ThreadPool* threadPool)
+    {
+        // Large ranges are swept in chunks on the worker pool, with each chunk filling its own partial results to be merged afterwards.
+        const size_t grainSize = std::max<size_t>(buildConfiguration.m_ParallelGrainSize, 1);
+        const size_t chunkCount = threadPool != nullptr ? (endIndex - beginIndex + grainSize - 1) / grainSize : 1;
+        auto ForEachChunk = [&](auto chunkFunction)
+        {
+            if (chunkCount > 1)
+            {
+                threadPool->ParallelFor(beginIndex, endIndex, grainSize, [&](size_t chunkBegin, size_t chunkEnd)
+                {
+                    chunkFunction((chunkBegin - beginIndex) / grainSize, chunkBegin, chunkEnd);
+                });
+            }
+            else
+            {
+                chunkFunction(0, beginIndex, endIndex);
+            }
+        };
+
+        // Binning only needs the spread of the object centers, not of their full bounding volumes.
+        const AABB emptyBounds(glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()));
+        std::vector<AABB> chunkCentroidBounds(chunkCount, emptyBounds);
+        ForEachChunk([&](size_t chunkIndex, size_t chunkBegin, size_t chunkEnd)
+        {
+            AABB& bounds = chunkCentroidBounds[chunkIndex];
+            for (size_t i = chunkBegin; i < chunkEnd; i++)
+            {
+                glm::vec3 center = m_Traits.GetAABB(targetObjects[i]).GetCenter();
+                bounds.m_Minimum = glm::min(bounds.m_Minimum, center);
+                bounds.m_Maximum = glm::max(bounds.m_Maximum, center);
+            }
+        });
+
+        AABB centroidBounds = chunkCentroidBounds[0];
+        for (size_t chunkIndex = 1; chunkIndex < chunkCount; chunkIndex++)
+        {
+            centroidBounds.Expand(chunkCentroidBounds[chunkIndex]);
+        }
+
+        const size_t objectCount = endIndex - beginIndex;
+        const size_t middleIndex = beginIndex + objectCount / 2;
+        const glm::vec3 centroidExtent = centroidBounds.m_Maximum - centroidBounds.m_Minimum;
+
+        // All centers coincide, so no plane can separate them. Any split is as good as another.
+        if (centroidExtent.x <= 0.0f && centroidExtent.y <= 0.0f && centroidExtent.z <= 0.0f)
+        {
+            return middleIndex;
+        }
+
+        struct Bin
+        {
+            AABB m_AABB;
+            uint32_t m_ObjectCount = 0;
+        };
+
+        // Bins are laid out as [chunk][axis][bin].
+        const int binCount = (int)std::max(buildConfiguration.m_TopDownBinCount, 2u);
+        std::vector<Bin> chunkBins(chunkCount * 3 * binCount, Bin{ emptyBounds, 0 });
+
+        // Maps a center onto its bin along the given axis.
+        const glm::vec3 binScale = glm::vec3((float)binCount) / glm::max(centroidExtent, glm::vec3(std::numeric_limits<float>::min()));
+        auto GetBinIndex = [&](const glm::vec3& center, int axis)
+        {
+            int binIndex = (int)((center[axis] - centroidBounds.m_Minimum[axis]) * binScale[axis]);
+            return std::min(std::max(binIndex, 0), binCount - 1);
+        };
+
+        // A single pass over the range fills the bins of all three axes.
+        ForEachChunk([&](size_t chunkIndex, size_t chunkBegin, size_t chunkEnd)
+        {
+            Bin* bins = &chunkBins[chunkIndex * 3 * binCount];
+            for (size_t i = chunkBegin; i < chunkEnd; i++)
+            {
+                const AABB& objectAABB = m_Traits.GetAABB(targetObjects[i]);
+                glm::vec3 center = objectAABB.GetCenter();
+
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    Bin& bin = bins[axis * binCount + GetBinIndex(center, axis)];
+                    bin.m_AABB.Expand(objectAABB);
+                    bin.m_ObjectCount++;
+                }
+            }
+        });
+
+        // Fold the partial bins of every chunk into the first.
+        for (size_t chunkIndex = 1; chunkIndex < chunkCount; chunkIndex++)
+        {
+            for (int i = 0; i < 3 * binCount; i++)
+            {
+                const Bin& chunkBin = chunkBins[chunkIndex * 3 * binCount + i];
+                chunkBins[i].m_AABB.Expand(chunkBin.m_AABB);
+                chunkBins[i].m_ObjectCount += chunkBin.m_ObjectCount;
+            }
+        }
+
+        Bin* bins[3] = { &chunkBins[0], &chunkBins[binCount], &chunkBins[2 * binCount] };
+
+        int bestAxis = -1;
+        int bestBin = -1; // Objects in bins [0, bestBin] go to the left.
+        float bestCost = std::numeric_limits<float>::max();
+        std::vector<float> rightCosts(binCount);
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (centroidExtent[axis] <= 0.0f)
+            {
+                continue;
+            }
+
+            // Sweep from the right to record the cost of everything right of each plane...
+            AABB rightBounds = bins[axis][binCount - 1].m_AABB;
+            uint32_t rightCount = 0;
+            for (int i = binCount - 1; i > 0; i--)
+            {
+                rightBounds.Expand(bins[axis][i].m_AABB);
+                rightCount += bins[axis][i].m_ObjectCount;
+                rightCosts[i] = rightCount > 0 ? rightBounds.GetSurfaceArea() * (float)rightCount : 0.0f;
+            }
+
+            // ...then sweep from the left and combine with it. Plane i separates bins [0, i - 1] from [i, binCount - 1].
+            AABB leftBounds = bins[axis][0].m_AABB;
+            uint32_t leftCount = 0;
+            for (int i = 1; i < binCount; i++)
+            {
+                leftBounds.Expand(bins[axis][i - 1].m_AABB);
+                leftCount += bins[axis][i - 1].m_ObjectCount;
+
+                // Planes with an empty side do not split anything.
+                if (leftCount == 0 || leftCount == objectCount)
+                {
+                    continue;
+                }
+
+                // Normalized in the same way as the K-Split Points approach so that costs remain comparable.
+                float cost = (leftBounds.GetSurfaceArea() * (float)leftCount + rightCosts[i]) / (float)objectCount;
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = i - 1;
+                }
+            }
+        }
+
+        if (bestAxis == -1)
+        {
+            return middleIndex;
+        }
+
+        // Move objects left of the chosen plane to the front of the range.
+        return PartitionRange(targetObjects, beginIndex, endIndex, [&](const T& targetObject)
+        {
+            return GetBinIndex(m_Traits.GetAABB(targetObject).GetCenter(), bestAxis) <= bestBin;
+        }, threadPool, grainSize);
+    }
+
+    template <typename T, typename Traits>
+    template <typename Predicate>
+    size_t BVH<T, Traits>::PartitionRange(std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex, Predicate isLeft, ThreadPool* threadPool, size_t grainSize)
+    {
+        if (threadPool == nullptr || (endIndex - beginIndex) <= grainSize)
+        {
+            auto splitIterator = std::partition(targetObjects.begin() + beginIndex, targetObjects.begin() + endIndex, isLeft);
+            return (size_t)(splitIterator - targetObjects.begin());
+        }
+
+        // In parallel, count the left objects of each chunk. A prefix sum over these counts then gives every chunk its own output slots.
+        const size_t chunkCount = (endIndex - beginIndex + grainSize - 1) / grainSize;
+        std::vector<size_t> leftCounts(chunkCount, 0);
+        threadPool->ParallelFor(beginIndex, endIndex, grainSize, [&](size_t chunkBegin, size_t chunkEnd)
+        {
+            size_t& leftCount = leftCounts[(chunkBegin - beginIndex) / grainSize];
+            for (size_t i = chunkBegin; i < chunkEnd; i++)
+            {
+                leftCount += isLeft(targetObjects[i]) ? 1 : 0;
+            }
+        });
+
+        std::vector<size_t> leftOffsets(chunkCount);
+        std::vector<size_t> rightOffsets(chunkCount);
+        size_t totalLeftCount = 0;
+        for (size_t chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+        {
+            leftOffsets[chunkIndex] = totalLeftCount;
+            totalLeftCount += leftCounts[chunkIndex];
+        }
+        for (size_t chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+        {
+            rightOffsets[chunkIndex] = totalLeftCount + (chunkIndex * grainSize - leftOffsets[chunkIndex]);
+        }
+
+        // Scatter into a scratch list, then copy back.
+        std::vector<T> partitionedObjects(endIndex - beginIndex);
+        threadPool->ParallelFor(beginIndex, endIndex, grainSize, [&](size_t chunkBegin, size_t chunkEnd)
+        {
+            size_t chunkIndex = (chunkBegin - beginIndex) / grainSize;
+            size_t leftOffset = leftOffsets[chunkIndex];
+            size_t rightOffset = rightOffsets[chunkIndex];
+            for (size_t i = chunkBegin; i < chunkEnd; i++)
+            {
+                partitionedObjects[isLeft(targetObjects[i]) ? leftOffset++ : rightOffset++] = targetObjects[i];
+            }
+        });
+
+        threadPool->ParallelFor(0, partitionedObjects.size(), grainSize, [&](size_t chunkBegin, size_t chunkEnd)
+        {
+            std::copy(partitionedObjects.begin() + chunkBegin, partitionedObjects.begin() + chunkEnd, targetObjects.begin() + beginIndex + chunkBegin);
+        });
+
+        return beginIndex + totalLeftCount;
+    }
+
+    template <typename T, typename Traits>
+    typename BVH<T, Traits>::BVHNode* BVH<T, Traits>::BuildTopDownSweep(const BVHBuildConfiguration& buildConfiguration, ThreadPool* threadPool)
     {
-        // Ryan: Not using any configuration options here. This BottomUp build technique is optimized for speed and hence adheres strictly to it.
-        SPATIUM_UNREFERENCED_PARAMETER(buildConfiguration);
+        if (m_Objects.empty())
+        {
+            return nullptr;
+        }
+
+        SweepBuildState buildState;
+        buildState.m_SourceObjects = m_Objects;
+        buildState.m_IsLeft.resize(m_Objects.size());
+        buildState.m_ScratchIndices.resize(m_Objects.size());
+        buildState.m_RightAreas.resize(m_Objects.size());
+
+        std::vector<glm::vec3> objectCenters(m_Objects.size());
+        for (size_t i = 0; i < m_Objects.size(); i++)
+        {
+            objectCenters[i] = m_Traits.GetAABB(m_Objects[i]).GetCenter();
+        }
+
+        // This is the only sort of the whole build. Partitioning keeps the three lists sorted from here on.
+        auto SortAxis = [&](int axis)
+        {
+            std::vector<uint32_t>& sortedIndices = buildState.m_SortedIndices[axis];
+            sortedIndices.resize(m_Objects.size());
+            for (uint32_t i = 0; i < (uint32_t)sortedIndices.size(); i++)
+            {
+                sortedIndices[i] = i;
+            }
+
+            std::sort(sortedIndices.begin(), sortedIndices.end(), [&](uint32_t a, uint32_t b)
+            {
+                return objectCenters[a][axis] < objectCenters[b][axis];
+            });
+        };
+
+        if (threadPool != nullptr)
+        {
+            std::future<void> sortX = threadPool->Submit([&]() { SortAxis(0); });
+            std::future<void> sortY = threadPool->Submit([&]() { SortAxis(1); });
+            SortAxis(2);
+            threadPool->Wait(sortX);
+            threadPool->Wait(sortY);
+        }
+        else
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                SortAxis(axis);
+            }
+        }
+
+        return BuildTopDownSweepRecursive(buildState, 0, m_Objects.size(), buildConfiguration, 0, threadPool);
+    }
+
+    template <typename T, typename Traits>
+    typename BVH<T, Traits>::BVHNode* BVH<T, Traits>::BuildTopDownSweepRecursive(SweepBuildState& buildState, size_t beginIndex, size_t endIndex, const BVHBuildConfiguration& buildConfiguration, uint32_t currentDepth, ThreadPool* threadPool)
+    {
+        const std::vector<uint32_t>& sortedIndices = buildState.m_SortedIndices[0];
+
+        BVHNode* node = m_NodePool.Allocate();
+        for (size_t i = beginIndex; i < endIndex; i++)
+        {
+            node->m_AABB.Expand(m_Traits.GetAABB(buildState.m_SourceObjects[sortedIndices[i]]));
+        }
+
+        // Every list holds the same objects within the range, so any of them gives the leaf's objects.
+        if (currentDepth >= buildConfiguration.m_MaxDepth || (endIndex - beginIndex) <= buildConfiguration.m_MinimumObjects || node->m_AABB.GetVolume() <= buildConfiguration.m_MinimumVolume)
+        {
+            for (size_t i = beginIndex; i < endIndex; i++)
+            {
+                m_Objects[i] = buildState.m_SourceObjects[sortedIndices[i]];
+            }
+
+            AssignLeafObjects(node, (uint32_t)beginIndex, (uint32_t)(endIndex - beginIndex));
+            return node;
+        }
+
+        const size_t bestSplitPoint = PartitionObjectsSweep(buildState, beginIndex, endIndex);
+
+        // As with the other top down builds, both halves touch disjoint ranges of every list and so can be built concurrently.
+        if (threadPool != nullptr && (endIndex - beginIndex) >= buildConfiguration.m_ParallelGrainSize)
+        {
+            std::future<void> leftBuild = threadPool->Submit([&, beginIndex, bestSplitPoint, currentDepth]()
+            {
+                node->m_Children[0] = BuildTopDownSweepRecursive(buildState, beginIndex, bestSplitPoint, buildConfiguration, currentDepth + 1, threadPool);
+            });
+            node->m_Children[1] = BuildTopDownSweepRecursive(buildState, bestSplitPoint, endIndex, buildConfiguration, currentDepth + 1, threadPool);
+            threadPool->Wait(leftBuild);
+        }
+        else
+        {
+            node->m_Children[0] = BuildTopDownSweepRecursive(buildState, beginIndex, bestSplitPoint, buildConfiguration, currentDepth + 1, nullptr);
+            node->m_Children[1] = BuildTopDownSweepRecursive(buildState, bestSplitPoint, endIndex, buildConfiguration, currentDepth + 1, nullptr);
+        }
+
+        node->m_Children[0]->m_Parent = node;
+        node->m_Children[1]->m_Parent = node;
+        return node;
+    }
+
+    template <typename T, typename Traits>
+    size_t BVH<T, Traits>::PartitionObjectsSweep(SweepBuildState& buildState, size_t beginIndex, size_t endIndex)
+    {
+        const AABB emptyBounds(glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()));
+
+        const size_t middleIndex = beginIndex + (endIndex - beginIndex) / 2;
+        auto GetImbalance = [middleIndex](size_t splitPoint) { return splitPoint > middleIndex ? splitPoint - middleIndex : middleIndex - splitPoint; };
+
+        int bestAxis = 0;
+        float bestCost = std::numeric_limits<float>::max();
+        size_t bestSplitPoint = middleIndex;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            const std::vector<uint32_t>& sortedIndices = buildState.m_SortedIndices[axis];
+
+            // Sweeping in from the right stores the area of everything right of each split...
+            AABB rightBounds = emptyBounds;
+            for (size_t i = endIndex - 1; i > beginIndex; i--)
+            {
+                rightBounds.Expand(m_Traits.GetAABB(buildState.m_SourceObjects[sortedIndices[i]]));
+                buildState.m_RightAreas[i] = rightBounds.GetSurfaceArea();
+            }
+
+            // ...so that sweeping back in from the left prices every split exactly.
+            AABB leftBounds = emptyBounds;
+            for (size_t i = beginIndex + 1; i < endIndex; i++)
+            {
+                leftBounds.Expand(m_Traits.GetAABB(buildState.m_SourceObjects[sortedIndices[i - 1]]));
 
+                // Ties go to the more even split, so that piles of identical boxes don't degenerate into a list.
+                const float cost = leftBounds.GetSurfaceArea() * (float)(i - beginIndex) + buildState.m_RightAreas[i] * (float)(endIndex - i);
+                if (cost < bestCost || (cost == bestCost && GetImbalance(i) < GetImbalance(bestSplitPoint)))
+                {
+                    bestCost = cost;
+                    bestSplitPoint = i;
+                    bestAxis = axis;
+                }
+            }
+        }
+
+        // Flag the objects left of the split, then stably partition the other two lists by the flags, which keeps both halves of each sorted.
+        const std::vector<uint32_t>& splitIndices = buildState.m_SortedIndices[bestAxis];
+        for (size_t i = beginIndex; i < endIndex; i++)
+        {
+            buildState.m_IsLeft[splitIndices[i]] = i < bestSplitPoint;
+        }
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (axis == bestAxis)
+            {
+                continue;
+            }
+
+            std::vector<uint32_t>& sortedIndices = buildState.m_SortedIndices[axis];
+            size_t leftIndex = beginIndex;
+            size_t rightIndex = bestSplitPoint;
+            for (size_t i = beginIndex; i < endIndex; i++)
+            {
+                const uint32_t objectIndex = sortedIndices[i];
+                buildState.m_ScratchIndices[buildState.m_IsLeft[objectIndex] ? leftIndex++ : rightIndex++] = objectIndex;
+            }
+
+            std::copy(buildState.m_ScratchIndices.begin() + beginIndex, buildState.m_ScratchIndices.begin() + endIndex, sortedIndices.begin() + beginIndex);
+        }
+
+        return bestSplitPoint;
+    }
+
+    template <typename T, typename Traits>
+    template <typename Iterator>
+    void BVH<T, Traits>::BuildBottomUp(Iterator itBegin, Iterator itEnd, const BVHBuildConfiguration& buildConfiguration)
+    {
         Clear();
 
+        if (buildConfiguration.m_BottomUpStrategy == BVHBottomUpStrategy::LocallyOrderedClustering)
+        {
+            std::vector<T> sceneObjects(itBegin, itEnd);
+            m_ObjectCount = (uint32_t)sceneObjects.size();
+            m_Root = BuildLocallyOrderedClusters(sceneObjects, buildConfiguration, AcquireThreadPool(buildConfiguration.m_ThreadCount));
+            m_LastBuildSAHCost = ComputeSAHCost();
+            return;
+        }
+
+        // Ryan: Not using any other configuration options here. This BottomUp build technique is optimized for speed and hence adheres strictly to it.
         // Insert all objects into vector.
+        m_Objects.assign(itBegin, itEnd);
+        m_ObjectCount = (uint32_t)m_Objects.size();
+
         std::vector<BVHNode*> objectNodes;
-        objectNodes.reserve(itEnd - itBegin);
-        for (Iterator it = itBegin; it != itEnd; it++)
+        objectNodes.reserve(m_Objects.size());
+        for (uint32_t i = 0; i < m_ObjectCount; i++)
         {
-            BVHNode* leafNode = new BVHNode();
-            leafNode->AddObject(*it);
+            BVHNode* leafNode = m_NodePool.Allocate();
+            AssignLeafObjects(leafNode, i, 1);
             objectNodes.push_back(leafNode);
-            m_ObjectCount++;
         }
 
         m_Root = BuildBottomUpIterative(objectNodes);
+        m_LastBuildSAHCost = ComputeSAHCost();
     }
 
-    template <typename T>
-    typename BVH<T>::BVHNode* BVH<T>::BuildBottomUpIterative(std::vector<BVHNode*>& objectNodes)
+    template <typename T, typename Traits>
+    typename BVH<T, Traits>::BVHNode* BVH<T, Traits>::BuildBottomUpIterative(std::vector<BVHNode*>& objectNodes)
     {
         // Perform a first pass for each node to keep track of which other node is the best one. This cuts down the construction time drastically!
         auto nodeComparator = [](const std::pair<BVHNode*, float>& a, const std::pair<BVHNode*, float>& b)
@@ -243,42 +648,161 @@ namespace Spatium
         return priorityQueue.top().first;  // This is the root of the final BVH
     }
 
-    template <typename T>
-    typename BVH<T>::BVHNode* BVH<T>::FindBestMergeCandidate(BVHNode* node, const std::vector<BVHNode*>& nodes)
+    template <typename T, typename Traits>
+    typename BVH<T, Traits>::BVHNode* BVH<T, Traits>::BuildLocallyOrderedClusters(const std::vector<T>& targetObjects, const BVHBuildConfiguration& buildConfiguration, ThreadPool* threadPool)
     {
-        BVHNode* bestCandidate = nullptr;
-        float bestCost = std::numeric_limits<float>::max();
+        if (targetObjects.empty())
+        {
+            return nullptr;
+        }
 
-        for (BVHNode* candidateNode : nodes)
+        // Along the Morton curve, a cluster's best merge partner is almost always among its immediate neighbours. Sorting once
+        // therefore lets every cluster search a small window instead of all other clusters.
+        std::vector<MortonPrimitive> mortonPrimitives;
+        ComputeMortonCodes(targetObjects, mortonPrimitives, buildConfiguration.m_MortonCodeBits, threadPool, buildConfiguration.m_ParallelGrainSize);
+        SortMortonCodes(mortonPrimitives, buildConfiguration.m_MortonCodeBits);
+
+        std::vector<BVHNode*> clusters(targetObjects.size());
+        std::vector<AABB> clusterBounds(targetObjects.size()); // Kept alongside the clusters so that neighbour searches stay within one array.
+        m_Objects.resize(targetObjects.size());
+        for (size_t i = 0; i < clusters.size(); i++)
         {
-            if (candidateNode == node || candidateNode->m_Parent != nullptr)
+            m_Objects[i] = targetObjects[mortonPrimitives[i].m_ObjectIndex];
+            clusters[i] = m_NodePool.Allocate();
+            AssignLeafObjects(clusters[i], (uint32_t)i, 1);
+            clusterBounds[i] = clusters[i]->m_AABB;
+        }
+
+        const int64_t searchRadius = std::max<int64_t>(buildConfiguration.m_ClusteringSearchRadius, 1);
+        const size_t grainSize = buildConfiguration.m_ParallelGrainSize;
+        auto RunRange = [&](size_t beginIndex, size_t endIndex, auto rangeFunction)
+        {
+            if (threadPool != nullptr)
             {
-                continue;
+                threadPool->ParallelFor(beginIndex, endIndex, grainSize, rangeFunction);
             }
-
-            float currentCost = node->m_AABB.Union(candidateNode->m_AABB).GetSurfaceArea();
-            if (currentCost < bestCost)
+            else
             {
-                bestCost = currentCost;
-                bestCandidate = candidateNode;
+                rangeFunction(beginIndex, endIndex);
             }
-        }
+        };
 
-        return bestCandidate;
-    }
+        std::vector<int64_t> nearestNeighbours(clusters.size());
+        std::vector<BVHNode*> mergedClusters(clusters.size());
+        std::vector<AABB> mergedBounds(clusters.size());
 
-    template <typename T>
-    typename BVH<T>::BVHNode* BVH<T>::CreateParentNode(BVHNode* leftNode, BVHNode* rightNode)
-    {
-        // Create a new parent node.
-        BVHNode* parentNode = new BVHNode();
+        while (clusters.size() > 1)
+        {
+            const int64_t clusterCount = (int64_t)clusters.size();
 
-        // Set the left and right children of the parent node.
-        parentNode->m_Children[0] = leftNode;
-        parentNode->m_Children[1] = rightNode;
+            // Find each cluster's nearest neighbour within the window. Ties are broken by pair indices so that preference is a strict
+            // order over pairs. The globally cheapest pair is then always mutual, which guarantees every pass merges at least once.
+            RunRange(0, clusters.size(), [&](size_t beginIndex, size_t endIndex)
+            {
+                for (int64_t i = (int64_t)beginIndex; i < (int64_t)endIndex; i++)
+                {
+                    float bestCost = std::numeric_limits<float>::max();
+                    int64_t bestNeighbour = -1;
 
-        // Compute the bounding volume that encompasses both child nodes.
-        parentNode->m_AABB = leftNode->m_AABB.Union(rightNode->m_AABB);
+                    int64_t windowEnd = std::min(i + searchRadius, clusterCount - 1);
+                    for (int64_t j = std::max<int64_t>(i - searchRadius, 0); j <= windowEnd; j++)
+                    {
+                        if (j == i)
+                        {
+                            continue;
+                        }
+
+                        float cost = clusterBounds[i].Union(clusterBounds[j]).GetSurfaceArea();
+                        if (cost < bestCost || (cost == bestCost && std::min(i, j) + std::max(i, j) * clusterCount < std::min(i, bestNeighbour) + std::max(i, bestNeighbour) * clusterCount))
+                        {
+                            bestCost = cost;
+                            bestNeighbour = j;
+                        }
+                    }
+
+                    nearestNeighbours[i] = bestNeighbour;
+                }
+            });
+
+            // Merge mutual pairs. The lower index of each pair creates the parent in its own slot and the higher index vacates its slot,
+            // so every cluster only ever writes to its own position.
+            RunRange(0, clusters.size(), [&](size_t beginIndex, size_t endIndex)
+            {
+                for (int64_t i = (int64_t)beginIndex; i < (int64_t)endIndex; i++)
+                {
+                    int64_t neighbour = nearestNeighbours[i];
+                    if (nearestNeighbours[neighbour] != i)
+                    {
+                        mergedClusters[i] = clusters[i];
+                        mergedBounds[i] = clusterBounds[i];
+                    }
+                    else if (i < neighbour)
+                    {
+                        mergedClusters[i] = CreateParentNode(clusters[i], clusters[neighbour]);
+                        mergedBounds[i] = mergedClusters[i]->m_AABB;
+                    }
+                    else
+                    {
+                        mergedClusters[i] = nullptr;
+                    }
+                }
+            });
+
+            // Compact the survivors. Merged parents take the place of their lower child, which keeps the list in Morton order.
+            size_t survivorCount = 0;
+            for (size_t i = 0; i < clusters.size(); i++)
+            {
+                if (mergedClusters[i] != nullptr)
+                {
+                    clusters[survivorCount] = mergedClusters[i];
+                    clusterBounds[survivorCount] = mergedBounds[i];
+                    survivorCount++;
+                }
+            }
+
+            clusters.resize(survivorCount);
+            clusterBounds.resize(survivorCount);
+        }
+
+        return clusters[0];
+    }
+
+    template <typename T, typename Traits>
+    typename BVH<T, Traits>::BVHNode* BVH<T, Traits>::FindBestMergeCandidate(BVHNode* node, const std::vector<BVHNode*>& nodes)
+    {
+        BVHNode* bestCandidate = nullptr;
+        float bestCost = std::numeric_limits<float>::max();
+
+        for (BVHNode* candidateNode : nodes)
+        {
+            if (candidateNode == node || candidateNode->m_Parent != nullptr)
+            {
+                continue;
+            }
+
+            float currentCost = node->m_AABB.Union(candidateNode->m_AABB).GetSurfaceArea();
+            if (currentCost < bestCost)
+            {
+                bestCost = currentCost;
+                bestCandidate = candidateNode;
+            }
+        }
+
+        return bestCandidate;
+    }
+
+    template <typename T, typename Traits>
+    typename BVH<T, Traits>::BVHNode* BVH<T, Traits>::CreateParentNode(BVHNode* leftNode, BVHNode* rightNode)
+    {
+        // Create a new parent node.
+        BVHNode* parentNode = m_NodePool.Allocate();
+
+        // Set the left and right children of the parent node.
+        parentNode->m_Children[0] = leftNode;
+        parentNode->m_Children[1] = rightNode;
+
+        // Compute the bounding volume that encompasses both child nodes.
+        parentNode->m_AABB = leftNode->m_AABB.Union(rightNode->m_AABB);
 
         // Set the parent pointers for the child nodes.
         leftNode->m_Parent = parentNode;
@@ -287,8 +811,8 @@ namespace Spatium
         return parentNode;
     }
 
-    template <typename T>
-    float BVH<T>::ComputeBestPairCost(BVHNode* node, const std::vector<BVHNode*>& nodes)
+    template <typename T, typename Traits>
+    float BVH<T, Traits>::ComputeBestPairCost(BVHNode* node, const std::vector<BVHNode*>& nodes)
     {
         // Keep track of the best cost thus far between the node and all other candidate nodes.
         float bestCost = std::numeric_limits<float>::max();
@@ -311,47 +835,301 @@ namespace Spatium
         return bestCost;
     }
 
-    template <typename T>
+    template <typename T, typename Traits>
+    template <typename Iterator>
+    void BVH<T, Traits>::BuildLinear(Iterator itBegin, Iterator itEnd, const BVHBuildConfiguration& buildConfiguration)
+    {
+        Clear();
+        std::vector<T> sceneObjects(itBegin, itEnd);
+        m_ObjectCount = (uint32_t)sceneObjects.size();
+
+        if (sceneObjects.empty())
+        {
+            return;
+        }
+
+        ThreadPool* threadPool = AcquireThreadPool(buildConfiguration.m_ThreadCount);
+
+        // Objects close to each other in space end up close to each other along the Morton curve, so sorting by code clusters them.
+        std::vector<MortonPrimitive> mortonPrimitives;
+        ComputeMortonCodes(sceneObjects, mortonPrimitives, buildConfiguration.m_MortonCodeBits, threadPool, buildConfiguration.m_ParallelGrainSize);
+        SortMortonCodes(mortonPrimitives, buildConfiguration.m_MortonCodeBits);
+
+        m_Root = BuildLinearHierarchy(sceneObjects, mortonPrimitives, buildConfiguration, threadPool);
+        m_LastBuildSAHCost = ComputeSAHCost();
+    }
+
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::ComputeMortonCodes(const std::vector<T>& targetObjects, std::vector<MortonPrimitive>& mortonPrimitives, uint32_t mortonCodeBits, ThreadPool* threadPool, size_t grainSize)
+    {
+        // Quantize centers relative to the bounds of all centers, not of all objects, to make full use of the available bits.
+        AABB centroidBounds(m_Traits.GetAABB(targetObjects[0]).GetCenter(), m_Traits.GetAABB(targetObjects[0]).GetCenter());
+        for (const T& targetObject : targetObjects)
+        {
+            glm::vec3 center = m_Traits.GetAABB(targetObject).GetCenter();
+            centroidBounds.m_Minimum = glm::min(centroidBounds.m_Minimum, center);
+            centroidBounds.m_Maximum = glm::max(centroidBounds.m_Maximum, center);
+        }
+
+        const uint32_t bitsPerAxis = mortonCodeBits > 30 ? 21 : 10;
+        const float cellCount = (float)((1u << bitsPerAxis) - 1);
+        const glm::vec3 extent = centroidBounds.m_Maximum - centroidBounds.m_Minimum;
+        const glm::vec3 scale = glm::vec3(cellCount) / glm::max(extent, glm::vec3(std::numeric_limits<float>::min()));
+
+        mortonPrimitives.resize(targetObjects.size());
+        auto EncodeRange = [&](size_t beginIndex, size_t endIndex)
+        {
+            for (size_t i = beginIndex; i < endIndex; i++)
+            {
+                glm::vec3 cell = glm::clamp((m_Traits.GetAABB(targetObjects[i]).GetCenter() - centroidBounds.m_Minimum) * scale, glm::vec3(0.0f), glm::vec3(cellCount));
+                mortonPrimitives[i].m_Code = EncodeMorton3D((uint32_t)cell.x, (uint32_t)cell.y, (uint32_t)cell.z);
+                mortonPrimitives[i].m_ObjectIndex = (uint32_t)i;
+            }
+        };
+
+        if (threadPool != nullptr)
+        {
+            threadPool->ParallelFor(0, targetObjects.size(), grainSize, EncodeRange);
+        }
+        else
+        {
+            EncodeRange(0, targetObjects.size());
+        }
+    }
+
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::SortMortonCodes(std::vector<MortonPrimitive>& mortonPrimitives, uint32_t mortonCodeBits)
+    {
+        // Least significant digit radix sort, 8 bits per pass. Only as many passes as the code has bits are needed.
+        const uint32_t bitsPerPass = 8;
+        const uint32_t passCount = ((mortonCodeBits > 30 ? 63 : 30) + bitsPerPass - 1) / bitsPerPass;
+
+        std::vector<MortonPrimitive> scratchPrimitives(mortonPrimitives.size());
+        for (uint32_t pass = 0; pass < passCount; pass++)
+        {
+            const uint32_t shift = pass * bitsPerPass;
+
+            size_t bucketOffsets[1 << bitsPerPass] = { };
+            for (const MortonPrimitive& mortonPrimitive : mortonPrimitives)
+            {
+                bucketOffsets[(mortonPrimitive.m_Code >> shift) & 0xff]++;
+            }
+
+            size_t offset = 0;
+            for (size_t& bucketOffset : bucketOffsets)
+            {
+                size_t bucketSize = bucketOffset;
+                bucketOffset = offset;
+                offset += bucketSize;
+            }
+
+            // Scattering in input order keeps each pass stable, which the next pass relies on.
+            for (const MortonPrimitive& mortonPrimitive : mortonPrimitives)
+            {
+                scratchPrimitives[bucketOffsets[(mortonPrimitive.m_Code >> shift) & 0xff]++] = mortonPrimitive;
+            }
+
+            mortonPrimitives.swap(scratchPrimitives);
+        }
+    }
+
+    template <typename T, typename Traits>
+    typename BVH<T, Traits>::BVHNode* BVH<T, Traits>::BuildLinearHierarchy(const std::vector<T>& targetObjects, const std::vector<MortonPrimitive>& mortonPrimitives, const BVHBuildConfiguration& buildConfiguration, ThreadPool* threadPool)
+    {
+        const int64_t objectCount = (int64_t)mortonPrimitives.size();
+
+        // Length of the common prefix of two sorted keys, or -1 if j is out of range. Duplicate codes are made unique by appending their index.
+        auto CommonPrefix = [&](int64_t i, int64_t j) -> int
+        {
+            if (j < 0 || j >= objectCount)
+            {
+                return -1;
+            }
+
+            uint64_t codeA = mortonPrimitives[i].m_Code;
+            uint64_t codeB = mortonPrimitives[j].m_Code;
+            if (codeA == codeB)
+            {
+                return 64 + CountLeadingZeros((uint64_t)(i ^ j));
+            }
+
+            return CountLeadingZeros(codeA ^ codeB);
+        };
+
+        // Karras: internal node i covers the key range [first, last] and splits it after position split. Every internal node can find
+        // its range and split on its own by searching the prefix lengths around key i, which makes this loop trivially parallel.
+        struct LinearNode
+        {
+            int64_t m_First;
+            int64_t m_Last;
+            int64_t m_Split;
+        };
+
+        std::vector<LinearNode> linearNodes(objectCount > 1 ? objectCount - 1 : 0);
+        auto ProcessRange = [&](size_t beginIndex, size_t endIndex)
+        {
+            for (int64_t i = (int64_t)beginIndex; i < (int64_t)endIndex; i++)
+            {
+                // The range extends towards the neighbour sharing the longer prefix.
+                int direction = CommonPrefix(i, i + 1) - CommonPrefix(i, i - 1) >= 0 ? 1 : -1;
+                int minimumPrefix = CommonPrefix(i, i - direction);
+
+                // Exponentially grow an upper bound for the range length, then binary search the exact other end.
+                int64_t maximumLength = 2;
+                while (CommonPrefix(i, i + maximumLength * direction) > minimumPrefix)
+                {
+                    maximumLength *= 2;
+                }
+
+                int64_t length = 0;
+                for (int64_t step = maximumLength / 2; step >= 1; step /= 2)
+                {
+                    if (CommonPrefix(i, i + (length + step) * direction) > minimumPrefix)
+                    {
+                        length += step;
+                    }
+                }
+
+                int64_t j = i + length * direction;
+
+                // Binary search the last key that still shares more than the node's prefix with key i.
+                int nodePrefix = CommonPrefix(i, j);
+                int64_t splitOffset = 0;
+                int64_t step = length;
+                do
+                {
+                    step = (step + 1) / 2;
+                    if (CommonPrefix(i, i + (splitOffset + step) * direction) > nodePrefix)
+                    {
+                        splitOffset += step;
+                    }
+                } while (step > 1);
+
+                linearNodes[i].m_First = std::min(i, j);
+                linearNodes[i].m_Last = std::max(i, j);
+                linearNodes[i].m_Split = i + splitOffset * direction + std::min(direction, 0);
+            }
+        };
+
+        if (threadPool != nullptr)
+        {
+            threadPool->ParallelFor(0, linearNodes.size(), buildConfiguration.m_ParallelGrainSize, ProcessRange);
+        }
+        else
+        {
+            ProcessRange(0, linearNodes.size());
+        }
+
+        // Leaves hold runs of Morton ordered objects, so store the objects in that order.
+        m_Objects.resize(mortonPrimitives.size());
+        for (size_t i = 0; i < mortonPrimitives.size(); i++)
+        {
+            m_Objects[i] = targetObjects[mortonPrimitives[i].m_ObjectIndex];
+        }
+
+        // Emit the hierarchy from the root (internal node 0). Ranges small enough or deep enough become leaves holding all of their objects.
+        struct PendingNode
+        {
+            BVHNode* m_Node;
+            int64_t m_First;
+            int64_t m_Last;
+            int64_t m_InternalIndex; // -1 for ranges of a single key.
+            uint32_t m_Depth;
+        };
+
+        BVHNode* rootNode = m_NodePool.Allocate();
+        std::vector<BVHNode*> internalNodes; // Parents always come before their children here.
+        std::vector<PendingNode> pendingNodes;
+        pendingNodes.push_back({ rootNode, 0, objectCount - 1, objectCount > 1 ? 0 : -1, 0 });
+
+        while (!pendingNodes.empty())
+        {
+            PendingNode pendingNode = pendingNodes.back();
+            pendingNodes.pop_back();
+
+            int64_t rangeSize = pendingNode.m_Last - pendingNode.m_First + 1;
+            if (pendingNode.m_InternalIndex < 0 || rangeSize <= (int64_t)buildConfiguration.m_MinimumObjects || pendingNode.m_Depth >= buildConfiguration.m_MaxDepth)
+            {
+                AssignLeafObjects(pendingNode.m_Node, (uint32_t)pendingNode.m_First, (uint32_t)rangeSize);
+                continue;
+            }
+
+            const LinearNode& linearNode = linearNodes[pendingNode.m_InternalIndex];
+            internalNodes.push_back(pendingNode.m_Node);
+
+            // A child covering a single key is a leaf. Otherwise, the internal node at the split is the one starting (or ending) there.
+            int64_t childRanges[2][2] = { { linearNode.m_First, linearNode.m_Split }, { linearNode.m_Split + 1, linearNode.m_Last } };
+            for (int i = 0; i < 2; i++)
+            {
+                BVHNode* childNode = m_NodePool.Allocate();
+                childNode->m_Parent = pendingNode.m_Node;
+                pendingNode.m_Node->m_Children[i] = childNode;
+
+                int64_t internalIndex = childRanges[i][0] == childRanges[i][1] ? -1 : (i == 0 ? linearNode.m_Split : linearNode.m_Split + 1);
+                pendingNodes.push_back({ childNode, childRanges[i][0], childRanges[i][1], internalIndex, pendingNode.m_Depth + 1 });
+            }
+        }
+
+        // Walking parents in reverse guarantees both children already have their bounds.
+        for (auto it = internalNodes.rbegin(); it != internalNodes.rend(); ++it)
+        {
+            (*it)->m_AABB = (*it)->m_Children[0]->m_AABB.Union((*it)->m_Children[1]->m_AABB);
+        }
+
+        return rootNode;
+    }
+
+    template <typename T, typename Traits>
     template <typename Iterator>
-    void BVH<T>::Insert(Iterator itBegin, Iterator itEnd, const BVHBuildConfiguration& buildConfiguration)
+    void BVH<T, Traits>::Insert(Iterator itBegin, Iterator itEnd, const BVHBuildConfiguration& buildConfiguration)
     {
         for (auto it = itBegin; it != itEnd; ++it)
         {
             Insert(*it, buildConfiguration);
-            m_ObjectCount++;
         }
     }
 
     // Inserts a single object into the BVH.
-    template <typename T>
-    void BVH<T>::Insert(T targetObject, const BVHBuildConfiguration& buildConfiguration)
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::Insert(T targetObject, const BVHBuildConfiguration& buildConfiguration)
+    {
+        InsertObject(targetObject, m_Traits.GetAABB(targetObject), buildConfiguration);
+    }
+
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::InsertObject(T targetObject, const AABB& insertionAABB, const BVHBuildConfiguration& buildConfiguration)
     {
+        m_ObjectCount++;
+
         // The first object that comes into the empty tree will always be its root.
         if (m_Root == nullptr)
         {
-            m_Root = new BVHNode();
-            m_Root->AddObject(targetObject);
+            m_Root = m_NodePool.Allocate();
+            AppendLeafObject(m_Root, targetObject);
+            m_Root->m_AABB.Expand(insertionAABB);
             return;
         }
 
         // First, we first find the best sibling for the object.
-        BVHNode* siblingNode = FindBestSibling(targetObject);
+        BVHNode* siblingNode = buildConfiguration.m_InsertionStrategy == BVHInsertionStrategy::BranchAndBoundSAH ? FindBestSiblingSAH(insertionAABB) : FindBestSibling(insertionAABB);
 
-        // If the volume exceeds the minimumly allowed volume, we split. This means the creation of a new parent node.
-        if (siblingNode->m_AABB.Union(targetObject->m_AABB).GetVolume() > buildConfiguration.m_MinimumVolume)
+        // If the volume exceeds the minimumly allowed volume, we split. This means the creation of a new parent node. Objects can only
+        // ever join leafs, so internal siblings are always split.
+        if (!siblingNode->IsLeaf() || siblingNode->m_AABB.Union(insertionAABB).GetVolume() > buildConfiguration.m_MinimumVolume)
         {
             // Create node for the current object.
-            BVHNode* newNode = new BVHNode();
-            newNode->AddObject(targetObject);
+            BVHNode* newNode = m_NodePool.Allocate();
+            AppendLeafObject(newNode, targetObject);
+            newNode->m_AABB.Expand(insertionAABB);
 
             // Obtain the old parent of the sibling node for reconnection later.
             BVHNode* oldParent = siblingNode->m_Parent;
             // Create node for our new parent.
-            BVHNode* newParent = new BVHNode();
+            BVHNode* newParent = m_NodePool.Allocate();
             // Reconnect to old parent.
             newParent->m_Parent = oldParent;
             // Create new bounding volume for the sibling and object.
-            newParent->m_AABB = siblingNode->m_AABB.Union(targetObject->m_AABB);
+            newParent->m_AABB = siblingNode->m_AABB.Union(newNode->m_AABB);
 
             // If the old parent wasn't a null pointer, it means we're somewhere in the hierarchy.
             if (oldParent != nullptr)
@@ -396,7 +1174,7 @@ namespace Spatium
                 parentNode->m_AABB = leftChild->m_AABB.Union(rightChild->m_AABB);
 
                 // Rebalance.
-                RotateRebalance(parentNode);
+                RotateRebalance(parentNode, buildConfiguration.m_InsertionStrategy);
 
                 parentNode = parentNode->m_Parent;
             }
@@ -404,7 +1182,8 @@ namespace Spatium
         else
         {
             // Add object to found node as it does not exceed volume capacity.
-            siblingNode->AddObject(targetObject);
+            AppendLeafObject(siblingNode, targetObject);
+            siblingNode->m_AABB.Expand(insertionAABB);
 
             // Head back up through the parent node and refit AABBs accordingly.
             BVHNode* parentNode = siblingNode->m_Parent;
@@ -416,15 +1195,95 @@ namespace Spatium
                 parentNode->m_AABB = leftChild->m_AABB.Union(rightChild->m_AABB);
 
                 // Rebalance based on configuration
-                RotateRebalance(parentNode);
+                RotateRebalance(parentNode, buildConfiguration.m_InsertionStrategy);
 
                 parentNode = parentNode->m_Parent;
             }
         }
     }
 
-    template <typename T>
-    typename BVH<T>::BVHNode* BVH<T>::FindBestSibling(T newObject)
+    template <typename T, typename Traits>
+    bool BVH<T, Traits>::Remove(T targetObject)
+    {
+        static_assert(Traits::s_HasNodeStorage, "Removing objects requires traits with node storage to find their leaf.");
+
+        BVHNode* leafNode = m_Traits.template GetNode<BVHNode>(targetObject);
+        if (leafNode == nullptr)
+        {
+            return false;
+        }
+
+        // Swap the object with the last one in its leaf's range and shorten the range. The freed entry is reused right away if it ends m_Objects.
+        const uint32_t lastIndex = leafNode->m_FirstObject + leafNode->m_ObjectCount - 1;
+        for (uint32_t objectIndex = leafNode->m_FirstObject; objectIndex <= lastIndex; objectIndex++)
+        {
+            if (m_Objects[objectIndex] == targetObject)
+            {
+                std::swap(m_Objects[objectIndex], m_Objects[lastIndex]);
+                break;
+            }
+        }
+
+        leafNode->m_ObjectCount--;
+        if (lastIndex + 1 == m_Objects.size())
+        {
+            m_Objects.pop_back();
+        }
+        else
+        {
+            m_StaleObjectCount++;
+        }
+
+        SetObjectNode(targetObject, nullptr);
+        m_ObjectCount--;
+
+        // Leafs with objects left keep their box. It still bounds them, and shrinking it to their exact boxes would strip the fattened margins
+        // they were reinserted with.
+        if (leafNode->m_ObjectCount > 0)
+        {
+            return true;
+        }
+
+        // Empty leafs are removed along with their parent, whose place is taken by the leaf's sibling.
+        if (leafNode == m_Root)
+        {
+            m_Root = nullptr;
+        }
+        else
+        {
+            m_NodePool.Free(DetachSubtree(leafNode));
+        }
+
+        m_NodePool.Free(leafNode);
+        return true;
+    }
+
+    template <typename T, typename Traits>
+    bool BVH<T, Traits>::Update(T targetObject, const AABB& newAABB, const glm::vec3& displacement, const BVHBuildConfiguration& buildConfiguration)
+    {
+        static_assert(Traits::s_HasNodeStorage, "Updating objects requires traits with node storage to find their leaf.");
+        m_Traits.SetAABB(targetObject, newAABB);
+
+        BVHNode* leafNode = m_Traits.template GetNode<BVHNode>(targetObject);
+        if (leafNode != nullptr && leafNode->m_AABB.Contains(newAABB))
+        {
+            return false;
+        }
+
+        // Fatten the box and stretch it in the direction the object is heading.
+        AABB fatAABB(newAABB.m_Minimum - glm::vec3(buildConfiguration.m_UpdateMargin), newAABB.m_Maximum + glm::vec3(buildConfiguration.m_UpdateMargin));
+        const glm::vec3 extrusion = displacement * buildConfiguration.m_UpdateDisplacementMultiplier;
+        fatAABB.m_Minimum += glm::min(extrusion, glm::vec3(0.0f));
+        fatAABB.m_Maximum += glm::max(extrusion, glm::vec3(0.0f));
+
+        Remove(targetObject);
+        InsertObject(targetObject, fatAABB, buildConfiguration);
+
+        return true;
+    }
+
+    template <typename T, typename Traits>
+    typename BVH<T, Traits>::BVHNode* BVH<T, Traits>::FindBestSibling(const AABB& newAABB)
     {
         BVHNode* currentNode = m_Root;
 
@@ -432,7 +1291,7 @@ namespace Spatium
         while (!currentNode->IsLeaf())
         {
             // Pair the new object with the current node.
-            AABB mergedAabb = currentNode->m_AABB.Union(newObject->m_AABB);
+            AABB mergedAabb = currentNode->m_AABB.Union(newAABB);
             float mergedVolume = mergedAabb.GetVolume();
 
             auto cost = 2.0 * mergedVolume;
@@ -440,12 +1299,12 @@ namespace Spatium
 
             // Cost to descend left.
             auto& leftNode = currentNode->m_Children[0];
-            mergedAabb = leftNode->m_AABB.Union(newObject->m_AABB);
+            mergedAabb = leftNode->m_AABB.Union(newAABB);
             auto leftCost = leftNode->IsLeaf() ? mergedAabb.GetVolume() + inheritenceCost : (mergedAabb.GetVolume() - leftNode->m_AABB.GetVolume()) + inheritenceCost;
 
             // Cost to descend right.
             auto& rightNode = currentNode->m_Children[1];
-            mergedAabb = rightNode->m_AABB.Union(newObject->m_AABB);
+            mergedAabb = rightNode->m_AABB.Union(newAABB);
             auto rightCost = rightNode->IsLeaf() ? mergedAabb.GetVolume() + inheritenceCost : (mergedAabb.GetVolume() - rightNode->m_AABB.GetVolume()) + inheritenceCost;
 
             // Already descended correctly.
@@ -468,8 +1327,8 @@ namespace Spatium
         return currentNode;
     }
 
-    template <typename T>
-    void BVH<T>::RotateRebalance(BVHNode* node)
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::RotateRebalance(BVHNode* node, BVHInsertionStrategy insertionStrategy)
     {
         if (node == nullptr || node->IsLeaf())
         {
@@ -489,13 +1348,19 @@ namespace Spatium
         BVHNode* nodeF = nodeC->m_Children[0];
         BVHNode* nodeG = nodeC->m_Children[1];
 
-        float b_cost = nodeB->m_AABB.GetVolume();
-        float c_cost = nodeC->m_AABB.GetVolume();
+        // Only the child that changes matters. Surface area is what traversal pays for, as it is proportional to the chance of a node being entered.
+        auto GetCost = [&](const AABB& aabb)
+        {
+            return insertionStrategy == BVHInsertionStrategy::BranchAndBoundSAH ? aabb.GetSurfaceArea() : aabb.GetVolume();
+        };
 
-        float cd_cost = (nodeE) ? nodeC->m_AABB.Union(nodeE->m_AABB).GetVolume() - b_cost : std::numeric_limits<float>::max();
-        float ce_cost = (nodeD) ? nodeC->m_AABB.Union(nodeD->m_AABB).GetVolume() - b_cost : std::numeric_limits<float>::max();
-        float bf_cost = (nodeG) ? nodeB->m_AABB.Union(nodeG->m_AABB).GetVolume() - c_cost : std::numeric_limits<float>::max();
-        float bg_cost = (nodeF) ? nodeB->m_AABB.Union(nodeF->m_AABB).GetVolume() - c_cost : std::numeric_limits<float>::max();
+        float b_cost = GetCost(nodeB->m_AABB);
+        float c_cost = GetCost(nodeC->m_AABB);
+
+        float cd_cost = (nodeE) ? GetCost(nodeC->m_AABB.Union(nodeE->m_AABB)) - b_cost : std::numeric_limits<float>::max();
+        float ce_cost = (nodeD) ? GetCost(nodeC->m_AABB.Union(nodeD->m_AABB)) - b_cost : std::numeric_limits<float>::max();
+        float bf_cost = (nodeG) ? GetCost(nodeB->m_AABB.Union(nodeG->m_AABB)) - c_cost : std::numeric_limits<float>::max();
+        float bg_cost = (nodeF) ? GetCost(nodeB->m_AABB.Union(nodeF->m_AABB)) - c_cost : std::numeric_limits<float>::max();
 
         float minCost = std::min({ bf_cost, bg_cost, cd_cost, ce_cost });
 
@@ -550,181 +1415,643 @@ namespace Spatium
         }
     }
 
-    template <typename T>
-    template <typename Function>
-    void BVH<T>::TraverseLevelOrderObjects(Function traversalFunction) const
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::OptimizeTreelets(const BVHOptimizationConfiguration& optimizationConfiguration)
     {
-        if (m_Root != nullptr)
+        if (m_Root == nullptr)
         {
-            // Applies the function to each object.
-            m_Root->TraverseLevelOrderObjects(traversalFunction);
+            return;
         }
-    }
 
-    template <typename T>
-    template <typename Function>
-    void BVH<T>::TraverseLevelOrder(Function traversalFunction) const
-    {
-        if (m_Root != nullptr)
-        {
-            // Applies the function to each node.
-            m_Root->TraverseLevelOrder(traversalFunction);
-        }
-    }
+        ThreadPool* threadPool = AcquireThreadPool(optimizationConfiguration.m_ThreadCount);
+        const uint32_t treeletLeafCount = std::min(std::max(optimizationConfiguration.m_TreeletLeafCount, 3u), 16u);
 
-    template <typename T>
-    bool BVH<T>::IsEmpty() const
-    {
-        return m_ObjectCount == 0;
-    }
+        // Only nodes with at least this many leaves below them are restructured. Doubling it every pass focuses later passes on the upper levels.
+        uint32_t minimumSubtreeLeaves = treeletLeafCount;
 
-    template <typename T>
-    int BVH<T>::GetDepth() const
-    {
-        if (m_Root != nullptr)
+        for (uint32_t iteration = 0; iteration < optimizationConfiguration.m_TreeletIterations; iteration++)
         {
-            return m_Root->GetDepth();
-        }
+            // Group nodes by height. Nodes of equal height can never be ancestors of one another, so their treelets never touch and
+            // each group can be processed in parallel. Processing lower groups first lets the improvements propagate upwards.
+            std::vector<std::vector<BVHNode*>> nodesByHeight;
 
-        return -1;
-    }
+            struct PendingNode
+            {
+                BVHNode* m_Node;
+                bool m_ChildrenVisited;
+            };
 
-    // Returns the number of nodes in the tree.
-    template <typename T>
-    int BVH<T>::GetSize() const
-    {
-        if (m_Root != nullptr)
-        {
-            return m_Root->GetSize();
-        }
+            struct SubtreeInfo
+            {
+                uint32_t m_Height;
+                uint32_t m_LeafCount;
+            };
 
-        return 0;
-    }
+            std::vector<PendingNode> pendingNodes = { { m_Root, false } };
+            std::vector<SubtreeInfo> subtreeInfos; // Post order results for the children of the nodes on the pending stack.
+            while (!pendingNodes.empty())
+            {
+                PendingNode pendingNode = pendingNodes.back();
+                if (pendingNode.m_Node->IsLeaf())
+                {
+                    subtreeInfos.push_back({ 0, 1 });
+                    pendingNodes.pop_back();
+                    continue;
+                }
 
-    template <typename T>
-    typename BVH<T>::BVHNode const* BVH<T>::GetRoot() const
-    {
-        return m_Root;
+                if (!pendingNode.m_ChildrenVisited)
+                {
+                    pendingNodes.back().m_ChildrenVisited = true;
+                    pendingNodes.push_back({ pendingNode.m_Node->m_Children[0], false });
+                    pendingNodes.push_back({ pendingNode.m_Node->m_Children[1], false });
+                    continue;
+                }
+
+                SubtreeInfo rightInfo = subtreeInfos.back();
+                subtreeInfos.pop_back();
+                SubtreeInfo leftInfo = subtreeInfos.back();
+                subtreeInfos.pop_back();
+
+                SubtreeInfo nodeInfo = { std::max(leftInfo.m_Height, rightInfo.m_Height) + 1, leftInfo.m_LeafCount + rightInfo.m_LeafCount };
+                subtreeInfos.push_back(nodeInfo);
+                pendingNodes.pop_back();
+
+                // Nodes of height 1 only have their own two leaves, which leaves nothing to rearrange.
+                if (nodeInfo.m_Height >= 2 && nodeInfo.m_LeafCount >= minimumSubtreeLeaves)
+                {
+                    if (nodesByHeight.size() <= nodeInfo.m_Height)
+                    {
+                        nodesByHeight.resize(nodeInfo.m_Height + 1);
+                    }
+                    nodesByHeight[nodeInfo.m_Height].push_back(pendingNode.m_Node);
+                }
+            }
+
+            for (std::vector<BVHNode*>& treeletRoots : nodesByHeight)
+            {
+                auto RestructureRange = [&](size_t beginIndex, size_t endIndex)
+                {
+                    for (size_t i = beginIndex; i < endIndex; i++)
+                    {
+                        RestructureTreelet(treeletRoots[i], treeletLeafCount);
+                    }
+                };
+
+                if (threadPool != nullptr)
+                {
+                    threadPool->ParallelFor(0, treeletRoots.size(), 64, RestructureRange);
+                }
+                else
+                {
+                    RestructureRange(0, treeletRoots.size());
+                }
+            }
+
+            minimumSubtreeLeaves *= 2;
+        }
+
+        // Later refits measure their degradation against the optimized tree.
+        m_LastBuildSAHCost = ComputeSAHCost();
     }
 
-    template <typename T>
-    AABB BVH<T>::CreateEncapsulatingBoundingVolume(const std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex)
+    template <typename T, typename Traits>
+    bool BVH<T, Traits>::RestructureTreelet(BVHNode* treeletRoot, uint32_t treeletLeafCount)
     {
-        AABB aabb = targetObjects[beginIndex]->m_AABB;
-        for (size_t i = beginIndex + 1; i < endIndex; ++i)
+        // Grow the treelet by repeatedly expanding its largest leaf, as large nodes are where a better topology pays off the most.
+        std::vector<BVHNode*> treeletLeaves = { treeletRoot->m_Children[0], treeletRoot->m_Children[1] };
+        std::vector<BVHNode*> treeletInternals = { treeletRoot };
+        while (treeletLeaves.size() < treeletLeafCount)
+        {
+            int largestLeaf = -1;
+            float largestSurfaceArea = -1.0f;
+            for (size_t i = 0; i < treeletLeaves.size(); i++)
+            {
+                float surfaceArea = treeletLeaves[i]->m_AABB.GetSurfaceArea();
+                if (!treeletLeaves[i]->IsLeaf() && surfaceArea > largestSurfaceArea)
+                {
+                    largestSurfaceArea = surfaceArea;
+                    largestLeaf = (int)i;
+                }
+            }
+
+            if (largestLeaf == -1)
+            {
+                break;
+            }
+
+            BVHNode* expandedNode = treeletLeaves[largestLeaf];
+            treeletInternals.push_back(expandedNode);
+            treeletLeaves[largestLeaf] = expandedNode->m_Children[0];
+            treeletLeaves.push_back(expandedNode->m_Children[1]);
+        }
+
+        const uint32_t leafCount = (uint32_t)treeletLeaves.size();
+        if (leafCount < 3)
         {
-            aabb.Expand(targetObjects[i]->m_AABB);
+            return false;
         }
-        return aabb;
+
+        // Only the surface area of the treelet's internal nodes depends on its topology. The leaves below stay untouched, so the
+        // lowest cost for every subset of leaves is the area of their union plus the cheapest way to split them into two subsets.
+        const uint32_t subsetCount = 1u << leafCount;
+        std::vector<float> subsetAreas(subsetCount);
+        std::vector<float> subsetCosts(subsetCount);
+        std::vector<uint32_t> subsetPartitions(subsetCount);
+
+        for (uint32_t subset = 1; subset < subsetCount; subset++)
+        {
+            AABB subsetAABB(glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()));
+            for (uint32_t i = 0; i < leafCount; i++)
+            {
+                if (subset & (1u << i))
+                {
+                    subsetAABB.Expand(treeletLeaves[i]->m_AABB);
+                }
+            }
+            subsetAreas[subset] = subsetAABB.GetSurfaceArea();
+        }
+
+        // Subsets are visited in increasing order, so every proper subset is solved before the sets containing it.
+        for (uint32_t subset = 1; subset < subsetCount; subset++)
+        {
+            if ((subset & (subset - 1)) == 0)
+            {
+                subsetCosts[subset] = 0.0f; // A single leaf.
+                continue;
+            }
+
+            // Only partitions containing the lowest leaf are enumerated, as the rest are the same partitions mirrored.
+            const uint32_t lowestLeaf = subset & (~subset + 1);
+            float bestCost = std::numeric_limits<float>::max();
+            uint32_t bestPartition = 0;
+            for (uint32_t partition = (subset - 1) & subset; partition != 0; partition = (partition - 1) & subset)
+            {
+                if ((partition & lowestLeaf) == 0)
+                {
+                    continue;
+                }
+
+                float cost = subsetCosts[partition] + subsetCosts[subset ^ partition];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestPartition = partition;
+                }
+            }
+
+            subsetCosts[subset] = subsetAreas[subset] + bestCost;
+            subsetPartitions[subset] = bestPartition;
+        }
+
+        float currentCost = 0.0f;
+        for (BVHNode* internalNode : treeletInternals)
+        {
+            currentCost += internalNode->m_AABB.GetSurfaceArea();
+        }
+
+        // Leave the treelet alone unless the gain is more than floating point noise.
+        if (subsetCosts[subsetCount - 1] >= currentCost * 0.9999f)
+        {
+            return false;
+        }
+
+        // Rebuild the optimal topology from the recorded partitions, reusing the treelet's internal nodes. The root goes first so that
+        // it keeps its place in the tree.
+        size_t nextInternalNode = 0;
+        std::function<BVHNode*(uint32_t)> Rebuild = [&](uint32_t subset) -> BVHNode*
+        {
+            if ((subset & (subset - 1)) == 0)
+            {
+                uint32_t leafIndex = 0;
+                while ((subset >> leafIndex) != 1u)
+                {
+                    leafIndex++;
+                }
+                return treeletLeaves[leafIndex];
+            }
+
+            BVHNode* node = treeletInternals[nextInternalNode++];
+            BVHNode* leftChild = Rebuild(subsetPartitions[subset]);
+            BVHNode* rightChild = Rebuild(subset ^ subsetPartitions[subset]);
+
+            node->m_Children[0] = leftChild;
+            node->m_Children[1] = rightChild;
+            leftChild->m_Parent = node;
+            rightChild->m_Parent = node;
+            node->m_AABB = leftChild->m_AABB.Union(rightChild->m_AABB);
+            return node;
+        };
+
+        Rebuild(subsetCount - 1);
+        return true;
     }
 
-    /// ====================================================
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::OptimizeReinsertion(const BVHOptimizationConfiguration& optimizationConfiguration)
+    {
+        const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        auto IsOutOfTime = [&]()
+        {
+            return optimizationConfiguration.m_ReinsertionTimeBudget > 0.0f && std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count() >= optimizationConfiguration.m_ReinsertionTimeBudget;
+        };
+
+        float previousCost = ComputeSAHCost();
+        for (uint32_t iteration = 0; iteration < optimizationConfiguration.m_ReinsertionIterations && !IsOutOfTime(); iteration++)
+        {
+            // The root cannot move, and its children have no other place to go.
+            if (m_Root == nullptr || m_Root->IsLeaf() || (m_Root->m_Children[0]->IsLeaf() && m_Root->m_Children[1]->IsLeaf()))
+            {
+                break;
+            }
+
+            // Rank internal nodes by Bittner's inefficiency measure: large nodes whose children are much smaller than themselves
+            // (in total and individually) indicate badly grouped children.
+            std::vector<std::pair<float, BVHNode*>> candidates;
+            std::vector<BVHNode*> pendingNodes = { m_Root->m_Children[0], m_Root->m_Children[1] };
+            while (!pendingNodes.empty())
+            {
+                BVHNode* node = pendingNodes.back();
+                pendingNodes.pop_back();
+
+                if (node->IsLeaf())
+                {
+                    continue;
+                }
+
+                float surfaceArea = node->m_AABB.GetSurfaceArea();
+                float leftSurfaceArea = std::max(node->m_Children[0]->m_AABB.GetSurfaceArea(), std::numeric_limits<float>::min());
+                float rightSurfaceArea = std::max(node->m_Children[1]->m_AABB.GetSurfaceArea(), std::numeric_limits<float>::min());
+                float sumRatio = surfaceArea / (0.5f * (leftSurfaceArea + rightSurfaceArea));
+                float minimumRatio = surfaceArea / std::min(leftSurfaceArea, rightSurfaceArea);
+                candidates.push_back({ sumRatio * minimumRatio * surfaceArea, node });
+
+                pendingNodes.push_back(node->m_Children[0]);
+                pendingNodes.push_back(node->m_Children[1]);
+            }
+
+            size_t batchSize = std::min(candidates.size(), std::max<size_t>((size_t)(candidates.size() * optimizationConfiguration.m_ReinsertionBatchFraction), 1));
+            std::partial_sort(candidates.begin(), candidates.begin() + batchSize, candidates.end(), [](const std::pair<float, BVHNode*>& a, const std::pair<float, BVHNode*>& b)
+            {
+                return a.first > b.first;
+            });
+
+            for (size_t i = 0; i < batchSize && !IsOutOfTime(); i++)
+            {
+                BVHNode* node = candidates[i].second;
+
+                // Earlier reinsertions in this batch may have moved the node to the root.
+                if (node->m_Parent == nullptr || node->IsLeaf())
+                {
+                    continue;
+                }
+
+                // Remove the node along with its parent, then reinsert both of its children individually, larger first. The two freed
+                // nodes become the parents at the children's new positions.
+                BVHNode* children[2] = { node->m_Children[0], node->m_Children[1] };
+                if (children[0]->m_AABB.GetSurfaceArea() < children[1]->m_AABB.GetSurfaceArea())
+                {
+                    std::swap(children[0], children[1]);
+                }
+
+                BVHNode* parentNode = DetachSubtree(node);
+                node->m_Children[0] = nullptr;
+                node->m_Children[1] = nullptr;
+                children[0]->m_Parent = nullptr;
+                children[1]->m_Parent = nullptr;
 
-    template <typename T>
-    BVH<T>::BVHNode::BVHNode() : m_Parent(nullptr), m_FirstObject(nullptr), m_LastObject(nullptr), m_Children{ nullptr, nullptr }
+                AttachSubtree(children[0], FindBestSiblingSAH(children[0]->m_AABB), node);
+                AttachSubtree(children[1], FindBestSiblingSAH(children[1]->m_AABB), parentNode);
+            }
+
+            // Stop once a pass no longer makes a meaningful difference.
+            float currentCost = ComputeSAHCost();
+            if (currentCost >= previousCost * 0.999f)
+            {
+                break;
+            }
+            previousCost = currentCost;
+        }
+
+        // Later refits measure their degradation against the optimized tree.
+        m_LastBuildSAHCost = ComputeSAHCost();
+    }
+
+    template <typename T, typename Traits>
+    typename BVH<T, Traits>::BVHNode* BVH<T, Traits>::DetachSubtree(BVHNode* node)
     {
-        m_AABB.m_Minimum = glm::vec3(std::numeric_limits<float>::max());
-        m_AABB.m_Maximum = glm::vec3(std::numeric_limits<float>::lowest());
+        BVHNode* parentNode = node->m_Parent;
+        BVHNode* siblingNode = parentNode->m_Children[0] == node ? parentNode->m_Children[1] : parentNode->m_Children[0];
+        BVHNode* grandparentNode = parentNode->m_Parent;
+
+        // The sibling takes the parent's place.
+        siblingNode->m_Parent = grandparentNode;
+        if (grandparentNode != nullptr)
+        {
+            if (grandparentNode->m_Children[0] == parentNode)
+            {
+                grandparentNode->m_Children[0] = siblingNode;
+            }
+            else
+            {
+                grandparentNode->m_Children[1] = siblingNode;
+            }
+
+            RefitAncestors(siblingNode);
+        }
+        else
+        {
+            m_Root = siblingNode;
+        }
+
+        node->m_Parent = nullptr;
+        parentNode->m_Parent = nullptr;
+        parentNode->m_Children[0] = nullptr;
+        parentNode->m_Children[1] = nullptr;
+        return parentNode;
     }
 
-    template <typename T>
-    void BVH<T>::BVHNode::AddObject(T targetObject)
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::AttachSubtree(BVHNode* node, BVHNode* siblingNode, BVHNode* parentNode)
     {
-        if (m_FirstObject == nullptr)
+        BVHNode* oldParent = siblingNode->m_Parent;
+
+        // The new parent takes the sibling's place...
+        parentNode->m_Parent = oldParent;
+        if (oldParent != nullptr)
         {
-            m_FirstObject = targetObject;
-            m_LastObject = targetObject;
+            if (oldParent->m_Children[0] == siblingNode)
+            {
+                oldParent->m_Children[0] = parentNode;
+            }
+            else
+            {
+                oldParent->m_Children[1] = parentNode;
+            }
         }
         else
         {
-            m_LastObject->m_BVHInfo.m_Next = targetObject;
-            targetObject->m_BVHInfo.m_Previous = m_LastObject;
-            m_LastObject = targetObject;
+            m_Root = parentNode;
         }
 
-        targetObject->m_BVHInfo.m_Node = this;
-        m_AABB.Expand(targetObject->m_AABB);
+        // ...and adopts both the sibling and the node.
+        parentNode->m_Children[0] = siblingNode;
+        parentNode->m_Children[1] = node;
+        siblingNode->m_Parent = parentNode;
+        node->m_Parent = parentNode;
+        parentNode->m_AABB = siblingNode->m_AABB.Union(node->m_AABB);
+
+        RefitAncestors(parentNode);
     }
 
-    template <typename T>
-    bool BVH<T>::BVHNode::IsLeaf() const
+    template <typename T, typename Traits>
+    typename BVH<T, Traits>::BVHNode* BVH<T, Traits>::FindBestSiblingSAH(const AABB& aabb) const
     {
-        // Each node only has 2 children.
-        return m_Children[0] == nullptr && m_Children[1] == nullptr;
+        // Branch and bound over the whole tree. Pairing with a node costs the surface area of the merged box, plus the growth it
+        // causes in every ancestor (the inherited cost). Since descending can only add to the inherited cost, a subtree can be pruned
+        // once its inherited cost alone plus the smallest possible merged box (the new box itself) reaches the best cost found so far.
+        const float surfaceArea = aabb.GetSurfaceArea();
+
+        BVHNode* bestSibling = m_Root;
+        float bestCost = m_Root->m_AABB.Union(aabb).GetSurfaceArea();
+
+        using Candidate = std::pair<float, BVHNode*>; // Inherited cost, node.
+        PriorityQueue<Candidate, std::greater<Candidate>> candidates;
+        candidates.Push({ 0.0f, m_Root });
+
+        while (!candidates.IsEmpty())
+        {
+            auto [inheritedCost, node] = candidates.Pop();
+
+            if (inheritedCost + surfaceArea >= bestCost)
+            {
+                break; // Every remaining candidate has at least this inherited cost.
+            }
+
+            float mergedSurfaceArea = node->m_AABB.Union(aabb).GetSurfaceArea();
+            float cost = mergedSurfaceArea + inheritedCost;
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSibling = node;
+            }
+
+            float childInheritedCost = inheritedCost + mergedSurfaceArea - node->m_AABB.GetSurfaceArea();
+            if (!node->IsLeaf() && childInheritedCost + surfaceArea < bestCost)
+            {
+                candidates.Push({ childInheritedCost, node->m_Children[0] });
+                candidates.Push({ childInheritedCost, node->m_Children[1] });
+            }
+        }
+
+        return bestSibling;
     }
 
-    template <typename T>
-    int BVH<T>::BVHNode::GetSize() const
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::RefitAncestors(BVHNode* node)
     {
-        if (IsLeaf())
+        for (BVHNode* parentNode = node->m_Parent; parentNode != nullptr; parentNode = parentNode->m_Parent)
         {
-            return 1;
+            parentNode->m_AABB = parentNode->m_Children[0]->m_AABB.Union(parentNode->m_Children[1]->m_AABB);
         }
+    }
 
-        int currentSize = 1; // Self
+    template <typename T, typename Traits>
+    float BVH<T, Traits>::Refit(uint32_t threadCount)
+    {
+        if (m_Root == nullptr)
+        {
+            return 1.0f;
+        }
 
-        if (m_Children[0] != nullptr)
+        ThreadPool* threadPool = AcquireThreadPool(threadCount);
+
+        // Split the top of the tree breadth first into enough subtrees to keep every thread busy. Each subtree is refit by a single task, after which
+        // the task climbs back up through the nodes above it. Those keep a counter of finished children, and only the task that finishes the second
+        // child goes on to refit the node, so every node is refit exactly once and only after both of its children.
+        struct UpperNode
         {
-            currentSize += m_Children[0]->GetSize();
+            BVHNode* m_Node;
+            uint32_t m_ParentIndex;
+            std::atomic<uint32_t> m_FinishedChildren = { 0 };
+        };
+
+        struct Subtree
+        {
+            BVHNode* m_Node;
+            uint32_t m_ParentIndex;
+        };
+
+        constexpr uint32_t s_NoParent = std::numeric_limits<uint32_t>::max();
+        const size_t targetSubtreeCount = threadPool != nullptr ? (size_t)threadPool->GetThreadCount() * 8 : 1;
+
+        std::deque<UpperNode> upperNodes; // Atomics can't be moved, which rules out a vector.
+        std::vector<Subtree> subtrees = { { m_Root, s_NoParent } };
+
+        for (size_t subtreeIndex = 0; subtreeIndex < subtrees.size() && subtrees.size() < targetSubtreeCount; )
+        {
+            // Expanded subtrees are replaced in place by their left child, so everything from subtreeIndex onwards remains unexpanded.
+            Subtree subtree = subtrees[subtreeIndex];
+            if (subtree.m_Node->IsLeaf())
+            {
+                subtreeIndex++;
+                continue;
+            }
+
+            upperNodes.emplace_back();
+            upperNodes.back().m_Node = subtree.m_Node;
+            upperNodes.back().m_ParentIndex = subtree.m_ParentIndex;
+
+            const uint32_t upperIndex = (uint32_t)upperNodes.size() - 1;
+            subtrees[subtreeIndex] = { subtree.m_Node->m_Children[0], upperIndex };
+            subtrees.push_back({ subtree.m_Node->m_Children[1], upperIndex });
         }
 
-        if (m_Children[1] != nullptr)
+        // Each task adds up the SAH cost of everything it refits.
+        std::vector<double> subtreeCosts(subtrees.size(), 0.0);
+
+        auto RefitRange = [&](size_t beginIndex, size_t endIndex)
         {
-            currentSize += m_Children[1]->GetSize();
+            for (size_t subtreeIndex = beginIndex; subtreeIndex < endIndex; subtreeIndex++)
+            {
+                double subtreeCost = RefitSubtree(subtrees[subtreeIndex].m_Node);
+
+                for (uint32_t parentIndex = subtrees[subtreeIndex].m_ParentIndex; parentIndex != s_NoParent; )
+                {
+                    UpperNode& upperNode = upperNodes[parentIndex];
+                    if (upperNode.m_FinishedChildren.fetch_add(1, std::memory_order_acq_rel) == 0)
+                    {
+                        break; // The sibling is still being refit, and its task will carry on from here.
+                    }
+
+                    upperNode.m_Node->m_AABB = upperNode.m_Node->m_Children[0]->m_AABB.Union(upperNode.m_Node->m_Children[1]->m_AABB);
+                    subtreeCost += upperNode.m_Node->m_AABB.GetSurfaceArea();
+                    parentIndex = upperNode.m_ParentIndex;
+                }
+
+                subtreeCosts[subtreeIndex] = subtreeCost;
+            }
+        };
+
+        if (threadPool != nullptr)
+        {
+            threadPool->ParallelFor(0, subtrees.size(), 1, RefitRange);
+        }
+        else
+        {
+            RefitRange(0, subtrees.size());
         }
 
-        return currentSize;
+        double totalCost = 0.0;
+        for (double subtreeCost : subtreeCosts)
+        {
+            totalCost += subtreeCost;
+        }
+
+        const float currentCost = (float)(totalCost / std::max((double)m_Root->m_AABB.GetSurfaceArea(), (double)std::numeric_limits<float>::min()));
+        // Trees that were only ever inserted into have no build to compare against, so their first refit becomes the baseline.
+        if (m_LastBuildSAHCost <= 0.0f)
+        {
+            m_LastBuildSAHCost = currentCost;
+        }
+
+        return m_LastBuildSAHCost > 0.0f ? currentCost / m_LastBuildSAHCost : 1.0f;
     }
 
-    // If there is only a single node in the tree, we should obtain a depth of 0.
-    template <typename T>
-    int BVH<T>::BVHNode::GetDepth() const
+    template <typename T, typename Traits>
+    double BVH<T, Traits>::RefitSubtree(BVHNode* subtreeRoot)
     {
-        if (m_Children[0] == nullptr && m_Children[1] == nullptr)
+        // Post order, so that children are always refit before their parent. Nodes are pushed once to expand them and once more to refit them.
+        double subtreeCost = 0.0;
+        TraversalStack<std::pair<BVHNode*, bool>> nodeStack;
+        nodeStack.Push({ subtreeRoot, false });
+
+        while (!nodeStack.IsEmpty())
         {
-            return 0;
-        }
+            auto [node, isExpanded] = nodeStack.Pop();
 
-        int leftDepth = m_Children[0] != nullptr ? m_Children[0]->GetDepth() : 0;
-        int rightDepth = m_Children[1] != nullptr ? m_Children[1]->GetDepth() : 0;
+            if (node->IsLeaf())
+            {
+                node->m_AABB = AABB(glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()));
+                uint32_t objectCount = 0;
 
-        return 1 + std::max(leftDepth, rightDepth);
+                ForEachLeafObject(node, [&](T currentObject)
+                {
+                    node->m_AABB.Expand(m_Traits.GetAABB(currentObject));
+                    objectCount++;
+                    return true;
+                });
+
+                subtreeCost += (double)node->m_AABB.GetSurfaceArea() * objectCount;
+            }
+            else if (isExpanded)
+            {
+                node->m_AABB = node->m_Children[0]->m_AABB.Union(node->m_Children[1]->m_AABB);
+                subtreeCost += node->m_AABB.GetSurfaceArea();
+            }
+            else
+            {
+                nodeStack.Push({ node, true });
+                nodeStack.Push({ node->m_Children[0], false });
+                nodeStack.Push({ node->m_Children[1], false });
+            }
+        }
+
+        return subtreeCost;
     }
 
-    template <typename T>
-    unsigned BVH<T>::BVHNode::GetObjectCount() const
+    template <typename T, typename Traits>
+    float BVH<T, Traits>::ComputeSAHCost() const
     {
-        // Remember that objects are only stored at the leaves.
-        unsigned objectCount = 0;
-        T objectIterator = m_FirstObject;
+        if (m_Root == nullptr)
+        {
+            return 0.0f;
+        }
 
-        while (objectIterator != nullptr)
+        // Each node is entered with a probability proportional to its surface area. Leaves additionally pay for testing each of their objects.
+        double totalCost = 0.0;
+        std::vector<const BVHNode*> pendingNodes = { m_Root };
+        while (!pendingNodes.empty())
         {
-            objectCount++;
-            objectIterator = objectIterator->m_BVHInfo.m_Next;
+            const BVHNode* node = pendingNodes.back();
+            pendingNodes.pop_back();
+
+            if (node->IsLeaf())
+            {
+                totalCost += (double)node->m_AABB.GetSurfaceArea() * node->GetObjectCount();
+            }
+            else
+            {
+                totalCost += node->m_AABB.GetSurfaceArea();
+                pendingNodes.push_back(node->m_Children[0]);
+                pendingNodes.push_back(node->m_Children[1]);
+            }
         }
 
-        return objectCount;
+        return (float)(totalCost / std::max((double)m_Root->m_AABB.GetSurfaceArea(), (double)std::numeric_limits<float>::min()));
     }
 
-    template <typename T>
+    template <typename T, typename Traits>
     template <typename Function>
-    void BVH<T>::BVHNode::TraverseLevelOrderObjects(Function traversalFunction) const
+    void BVH<T, Traits>::TraverseLevelOrderObjects(Function traversalFunction) const
     {
+        if (m_Root == nullptr)
+        {
+            return;
+        }
+
         std::queue<const BVHNode*> nodeQueue;
-        nodeQueue.push(this);
+        nodeQueue.push(m_Root);
 
         while (!nodeQueue.empty())
         {
             const BVHNode* currentNode = nodeQueue.front();
             nodeQueue.pop();
-            T currentObject = currentNode->m_FirstObject;
 
-            while (currentObject != nullptr)
+            ForEachLeafObject(currentNode, [&](T currentObject)
             {
                 traversalFunction(currentObject);
-                currentObject = currentObject->m_BVHInfo.m_Next;
-            }
+                return true;
+            });
 
             if (currentNode->m_Children[0] != nullptr)
             {
@@ -738,9 +2065,1084 @@ namespace Spatium
         }
     }
 
-    template <typename T>
+    template <typename T, typename Traits>
+    template <typename Function>
+    void BVH<T, Traits>::TraverseLevelOrder(Function traversalFunction) const
+    {
+        if (m_Root != nullptr)
+        {
+            // Applies the function to each node.
+            m_Root->TraverseLevelOrder(traversalFunction);
+        }
+    }
+
+    template <typename T, typename Traits>
+    template <typename Function>
+    T BVH<T, Traits>::IntersectClosest(const Ray& ray, float& hitDistance, Function intersectionFunction) const
+    {
+        return IntersectClosestFrom(m_Root, ray, hitDistance, intersectionFunction);
+    }
+
+    template <typename T, typename Traits>
+    template <typename Function>
+    bool BVH<T, Traits>::IntersectAny(const Ray& ray, float maximumDistance, Function intersectionFunction) const
+    {
+        return IntersectAnyFrom(m_Root, ray, maximumDistance, intersectionFunction);
+    }
+
+    template <typename T, typename Traits>
+    template <uint32_t PacketSize, typename Function>
+    void BVH<T, Traits>::IntersectClosest(const RayPacket<PacketSize>& rayPacket, float* hitDistances, T* hitObjects, Function intersectionFunction, float singleRayFraction) const
+    {
+        for (uint32_t rayIndex = 0; rayIndex < PacketSize; rayIndex++)
+        {
+            hitObjects[rayIndex] = m_Traits.GetNullObject();
+        }
+
+        if (m_Root == nullptr)
+        {
+            return;
+        }
+
+        struct PendingNode
+        {
+            const BVHNode* m_Node;
+            uint32_t m_ActiveMask;
+        };
+
+        const uint32_t singleRayLimit = (uint32_t)(singleRayFraction * (float)PacketSize);
+        TraversalStack<PendingNode> nodeStack;
+        nodeStack.Push({ m_Root, (uint32_t)((1ull << PacketSize) - 1) });
+
+        while (!nodeStack.IsEmpty())
+        {
+            PendingNode pendingNode = nodeStack.Pop();
+
+            // Rays drop out of the mask once they miss the node, or once they have already hit something closer than it.
+            const uint32_t activeMask = rayPacket.IntersectAABB(pendingNode.m_Node->m_AABB, hitDistances, pendingNode.m_ActiveMask);
+            if (activeMask == 0)
+            {
+                continue;
+            }
+
+            // With only a few rays left the packet tests mostly do wasted work, so let the remaining rays finish this subtree on their own.
+            if (CountActiveRays(activeMask) < singleRayLimit)
+            {
+                for (uint32_t rayIndex = 0; rayIndex < PacketSize; rayIndex++)
+                {
+                    if ((activeMask & (1u << rayIndex)) == 0)
+                    {
+                        continue;
+                    }
+
+                    T hitObject = IntersectClosestFrom(pendingNode.m_Node, rayPacket.GetRay(rayIndex), hitDistances[rayIndex], [&](T currentObject, float& hitDistance)
+                    {
+                        return intersectionFunction(currentObject, rayIndex, hitDistance);
+                    });
+
+                    if (hitObject != m_Traits.GetNullObject())
+                    {
+                        hitObjects[rayIndex] = hitObject;
+                    }
+                }
+
+                continue;
+            }
+
+            if (pendingNode.m_Node->IsLeaf())
+            {
+                ForEachLeafObject(pendingNode.m_Node, [&](T currentObject)
+                {
+                    const uint32_t objectMask = rayPacket.IntersectAABB(m_Traits.GetAABB(currentObject), hitDistances, activeMask);
+
+                    for (uint32_t rayIndex = 0; objectMask >> rayIndex; rayIndex++)
+                    {
+                        if ((objectMask & (1u << rayIndex)) && intersectionFunction(currentObject, rayIndex, hitDistances[rayIndex]))
+                        {
+                            hitObjects[rayIndex] = currentObject;
+                        }
+                    }
+
+                    return true;
+                });
+
+                continue;
+            }
+
+            // Rays in a coherent packet mostly agree on which child comes first, so order the children by the first active ray's direction.
+            uint32_t leadingRay = 0;
+            while ((activeMask & (1u << leadingRay)) == 0)
+            {
+                leadingRay++;
+            }
+
+            const glm::vec3 leadingDirection(rayPacket.m_DirectionX[leadingRay], rayPacket.m_DirectionY[leadingRay], rayPacket.m_DirectionZ[leadingRay]);
+            const glm::vec3 childOffset = pendingNode.m_Node->m_Children[1]->m_AABB.GetCenter() - pendingNode.m_Node->m_Children[0]->m_AABB.GetCenter();
+            const int nearChild = glm::dot(childOffset, leadingDirection) >= 0.0f ? 0 : 1;
+
+            nodeStack.Push({ pendingNode.m_Node->m_Children[1 - nearChild], activeMask });
+            nodeStack.Push({ pendingNode.m_Node->m_Children[nearChild], activeMask });
+        }
+    }
+
+    template <typename T, typename Traits>
+    template <uint32_t PacketSize, typename Function>
+    uint32_t BVH<T, Traits>::IntersectAny(const RayPacket<PacketSize>& rayPacket, const float* maximumDistances, Function intersectionFunction, float singleRayFraction) const
+    {
+        uint32_t hitMask = 0;
+        if (m_Root == nullptr)
+        {
+            return hitMask;
+        }
+
+        struct PendingNode
+        {
+            const BVHNode* m_Node;
+            uint32_t m_ActiveMask;
+        };
+
+        const uint32_t fullMask = (uint32_t)((1ull << PacketSize) - 1);
+        const uint32_t singleRayLimit = (uint32_t)(singleRayFraction * (float)PacketSize);
+        TraversalStack<PendingNode> nodeStack;
+        nodeStack.Push({ m_Root, fullMask });
+
+        while (!nodeStack.IsEmpty() && hitMask != fullMask)
+        {
+            PendingNode pendingNode = nodeStack.Pop();
+
+            // Rays that have hit anything since this node was pushed are done.
+            const uint32_t activeMask = rayPacket.IntersectAABB(pendingNode.m_Node->m_AABB, maximumDistances, pendingNode.m_ActiveMask & ~hitMask);
+            if (activeMask == 0)
+            {
+                continue;
+            }
+
+            if (CountActiveRays(activeMask) < singleRayLimit)
+            {
+                for (uint32_t rayIndex = 0; rayIndex < PacketSize; rayIndex++)
+                {
+                    if ((activeMask & (1u << rayIndex)) == 0)
+                    {
+                        continue;
+                    }
+
+                    const bool isHit = IntersectAnyFrom(pendingNode.m_Node, rayPacket.GetRay(rayIndex), maximumDistances[rayIndex], [&](T currentObject, float& hitDistance)
+                    {
+                        return intersectionFunction(currentObject, rayIndex, hitDistance);
+                    });
+
+                    hitMask |= (uint32_t)isHit << rayIndex;
+                }
+
+                continue;
+            }
+
+            if (pendingNode.m_Node->IsLeaf())
+            {
+                ForEachLeafObject(pendingNode.m_Node, [&](T currentObject)
+                {
+                    const uint32_t objectMask = rayPacket.IntersectAABB(m_Traits.GetAABB(currentObject), maximumDistances, activeMask & ~hitMask);
+
+                    for (uint32_t rayIndex = 0; objectMask >> rayIndex; rayIndex++)
+                    {
+                        float hitDistance = maximumDistances[rayIndex];
+                        if ((objectMask & (1u << rayIndex)) && intersectionFunction(currentObject, rayIndex, hitDistance))
+                        {
+                            hitMask |= 1u << rayIndex;
+                        }
+                    }
+
+                    return (activeMask & ~hitMask) != 0;
+                });
+
+                continue;
+            }
+
+            nodeStack.Push({ pendingNode.m_Node->m_Children[0], activeMask });
+            nodeStack.Push({ pendingNode.m_Node->m_Children[1], activeMask });
+        }
+
+        return hitMask;
+    }
+
+    template <typename T, typename Traits>
+    uint32_t BVH<T, Traits>::CountActiveRays(uint32_t activeMask)
+    {
+        uint32_t activeCount = 0;
+        for (; activeMask != 0; activeMask &= activeMask - 1)
+        {
+            activeCount++;
+        }
+
+        return activeCount;
+    }
+
+    template <typename T, typename Traits>
+    template <typename Function>
+    T BVH<T, Traits>::IntersectClosestFrom(const BVHNode* startNode, const Ray& ray, float& hitDistance, Function intersectionFunction) const
+    {
+        T closestObject = m_Traits.GetNullObject();
+        float entryDistance;
+
+        if (startNode == nullptr || !startNode->m_AABB.IntersectRay(ray, hitDistance, entryDistance))
+        {
+            return closestObject;
+        }
+
+        struct PendingNode
+        {
+            const BVHNode* m_Node;
+            float m_EntryDistance;
+        };
+
+        TraversalStack<PendingNode> nodeStack;
+        nodeStack.Push({ startNode, entryDistance });
+
+        while (!nodeStack.IsEmpty())
+        {
+            PendingNode pendingNode = nodeStack.Pop();
+
+            // Anything found since this node was pushed may already be closer than where the ray enters it.
+            if (pendingNode.m_EntryDistance > hitDistance)
+            {
+                continue;
+            }
+
+            if (pendingNode.m_Node->IsLeaf())
+            {
+                ForEachLeafObject(pendingNode.m_Node, [&](T currentObject)
+                {
+                    float objectDistance;
+                    if (m_Traits.GetAABB(currentObject).IntersectRay(ray, hitDistance, objectDistance) && intersectionFunction(currentObject, hitDistance))
+                    {
+                        closestObject = currentObject;
+                    }
+
+                    return true;
+                });
+
+                continue;
+            }
+
+            float leftDistance, rightDistance;
+            const bool hitsLeft = pendingNode.m_Node->m_Children[0]->m_AABB.IntersectRay(ray, hitDistance, leftDistance);
+            const bool hitsRight = pendingNode.m_Node->m_Children[1]->m_AABB.IntersectRay(ray, hitDistance, rightDistance);
+
+            // Push the farther child first so the nearer one is visited first, which tightens hitDistance as early as possible.
+            if (hitsLeft && hitsRight)
+            {
+                const bool isLeftNearer = leftDistance <= rightDistance;
+                nodeStack.Push({ pendingNode.m_Node->m_Children[isLeftNearer ? 1 : 0], isLeftNearer ? rightDistance : leftDistance });
+                nodeStack.Push({ pendingNode.m_Node->m_Children[isLeftNearer ? 0 : 1], isLeftNearer ? leftDistance : rightDistance });
+            }
+            else if (hitsLeft)
+            {
+                nodeStack.Push({ pendingNode.m_Node->m_Children[0], leftDistance });
+            }
+            else if (hitsRight)
+            {
+                nodeStack.Push({ pendingNode.m_Node->m_Children[1], rightDistance });
+            }
+        }
+
+        return closestObject;
+    }
+
+    template <typename T, typename Traits>
+    template <typename Function>
+    bool BVH<T, Traits>::IntersectAnyFrom(const BVHNode* startNode, const Ray& ray, float maximumDistance, Function intersectionFunction) const
+    {
+        float entryDistance;
+        if (startNode == nullptr || !startNode->m_AABB.IntersectRay(ray, maximumDistance, entryDistance))
+        {
+            return false;
+        }
+
+        // Any hit will do, so there is no point in ordering children.
+        TraversalStack<const BVHNode*> nodeStack;
+        nodeStack.Push(startNode);
+        bool isHit = false;
+
+        while (!nodeStack.IsEmpty() && !isHit)
+        {
+            const BVHNode* currentNode = nodeStack.Pop();
+
+            if (currentNode->IsLeaf())
+            {
+                ForEachLeafObject(currentNode, [&](T currentObject)
+                {
+                    float objectDistance = maximumDistance;
+                    isHit = m_Traits.GetAABB(currentObject).IntersectRay(ray, maximumDistance, entryDistance) && intersectionFunction(currentObject, objectDistance);
+                    return !isHit;
+                });
+
+                continue;
+            }
+
+            for (int childIndex = 0; childIndex < 2; childIndex++)
+            {
+                if (currentNode->m_Children[childIndex]->m_AABB.IntersectRay(ray, maximumDistance, entryDistance))
+                {
+                    nodeStack.Push(currentNode->m_Children[childIndex]);
+                }
+            }
+        }
+
+        return isHit;
+    }
+
+    template <typename T, typename Traits>
+    template <typename Function>
+    void BVH<T, Traits>::Query(const AABB& queryAABB, Function queryFunction) const
+    {
+        if (m_Root == nullptr)
+        {
+            return;
+        }
+
+        TraversalStack<const BVHNode*> nodeStack;
+        nodeStack.Push(m_Root);
+
+        while (!nodeStack.IsEmpty())
+        {
+            const BVHNode* node = nodeStack.Pop();
+            if (!node->m_AABB.Overlaps(queryAABB))
+            {
+                continue;
+            }
+
+            if (node->IsLeaf())
+            {
+                ForEachLeafObject(node, [&](T currentObject)
+                {
+                    if (m_Traits.GetAABB(currentObject).Overlaps(queryAABB))
+                    {
+                        queryFunction(currentObject);
+                    }
+
+                    return true;
+                });
+
+                continue;
+            }
+
+            nodeStack.Push(node->m_Children[1]);
+            nodeStack.Push(node->m_Children[0]);
+        }
+    }
+
+    template <typename T, typename Traits>
+    template <typename Function>
+    void BVH<T, Traits>::QueryFrustum(const Frustum& frustum, Function queryFunction) const
+    {
+        if (m_Root == nullptr)
+        {
+            return;
+        }
+
+        // Each node carries the planes its parent was not yet fully inside of, so they are the only ones left to test.
+        struct PendingNode
+        {
+            const BVHNode* m_Node;
+            uint32_t m_PlaneMask;
+        };
+
+        TraversalStack<PendingNode> nodeStack;
+        nodeStack.Push({ m_Root, 0x3fu });
+
+        while (!nodeStack.IsEmpty())
+        {
+            PendingNode pendingNode = nodeStack.Pop();
+            const FrustumClassification classification = frustum.ClassifyAABB(pendingNode.m_Node->m_AABB, pendingNode.m_PlaneMask);
+
+            if (classification == FrustumClassification::Outside)
+            {
+                continue;
+            }
+
+            // Everything below a node fully inside the frustum is visible as well.
+            if (classification == FrustumClassification::Inside)
+            {
+                ForEachSubtreeObject(pendingNode.m_Node, [&](T currentObject) { queryFunction(currentObject); });
+                continue;
+            }
+
+            if (pendingNode.m_Node->IsLeaf())
+            {
+                ForEachLeafObject(pendingNode.m_Node, [&](T currentObject)
+                {
+                    uint32_t objectPlaneMask = pendingNode.m_PlaneMask;
+                    if (frustum.ClassifyAABB(m_Traits.GetAABB(currentObject), objectPlaneMask) != FrustumClassification::Outside)
+                    {
+                        queryFunction(currentObject);
+                    }
+
+                    return true;
+                });
+
+                continue;
+            }
+
+            nodeStack.Push({ pendingNode.m_Node->m_Children[1], pendingNode.m_PlaneMask });
+            nodeStack.Push({ pendingNode.m_Node->m_Children[0], pendingNode.m_PlaneMask });
+        }
+    }
+
+    template <typename T, typename Traits>
+    template <typename Function>
+    void BVH<T, Traits>::QueryOverlappingPairs(Function pairFunction) const
+    {
+        if (m_Root != nullptr)
+        {
+            CollectOverlappingPairs(m_Root, m_Root, pairFunction);
+        }
+    }
+
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::FindOverlappingPairs(std::vector<std::pair<T, T>>& overlappingPairs, uint32_t threadCount) const
+    {
+        overlappingPairs.clear();
+        if (m_Root == nullptr)
+        {
+            return;
+        }
+
+        ThreadPool* threadPool = AcquireThreadPool(threadCount);
+        if (threadPool == nullptr)
+        {
+            CollectOverlappingPairs(m_Root, m_Root, [&](T objectA, T objectB) { overlappingPairs.emplace_back(objectA, objectB); });
+            return;
+        }
+
+        // Unfold the top of the descent breadth first into independent node pairs, splitting them the same way CollectOverlappingPairs would,
+        // until there are enough of them to keep every thread busy.
+        std::vector<std::pair<const BVHNode*, const BVHNode*>> nodePairs = { { m_Root, m_Root } };
+        const size_t targetPairCount = (size_t)threadPool->GetThreadCount() * 16;
+
+        for (size_t pairIndex = 0; pairIndex < nodePairs.size() && nodePairs.size() - pairIndex < targetPairCount; )
+        {
+            const BVHNode* nodeA = nodePairs[pairIndex].first;
+            const BVHNode* nodeB = nodePairs[pairIndex].second;
+
+            if (nodeA->IsLeaf() && nodeB->IsLeaf())
+            {
+                pairIndex++;
+                continue;
+            }
+
+            // Split pairs are replaced in place by their first sub-pair, so everything from pairIndex onwards remains unsplit.
+            std::pair<const BVHNode*, const BVHNode*> subPairs[3];
+            size_t subPairCount = 0;
+
+            if (nodeA == nodeB)
+            {
+                subPairs[subPairCount++] = { nodeA->m_Children[0], nodeA->m_Children[0] };
+                subPairs[subPairCount++] = { nodeA->m_Children[1], nodeA->m_Children[1] };
+
+                if (nodeA->m_Children[0]->m_AABB.Overlaps(nodeA->m_Children[1]->m_AABB))
+                {
+                    subPairs[subPairCount++] = { nodeA->m_Children[0], nodeA->m_Children[1] };
+                }
+            }
+            else
+            {
+                const bool splitA = nodeB->IsLeaf() || (!nodeA->IsLeaf() && nodeA->m_AABB.GetSurfaceArea() >= nodeB->m_AABB.GetSurfaceArea());
+                const BVHNode* splitNode = splitA ? nodeA : nodeB;
+                const BVHNode* otherNode = splitA ? nodeB : nodeA;
+
+                for (int childIndex = 0; childIndex < 2; childIndex++)
+                {
+                    if (splitNode->m_Children[childIndex]->m_AABB.Overlaps(otherNode->m_AABB))
+                    {
+                        subPairs[subPairCount++] = { splitNode->m_Children[childIndex], otherNode };
+                    }
+                }
+            }
+
+            if (subPairCount == 0)
+            {
+                nodePairs[pairIndex] = nodePairs.back();
+                nodePairs.pop_back();
+                continue;
+            }
+
+            nodePairs[pairIndex] = subPairs[0];
+            for (size_t subPairIndex = 1; subPairIndex < subPairCount; subPairIndex++)
+            {
+                nodePairs.push_back(subPairs[subPairIndex]);
+            }
+        }
+
+        // Each node pair writes into its own buffer, so threads never share one and the final order doesn't depend on scheduling.
+        std::vector<std::vector<std::pair<T, T>>> pairBuffers(nodePairs.size());
+        threadPool->ParallelFor(0, nodePairs.size(), 1, [&](size_t beginIndex, size_t endIndex)
+        {
+            for (size_t pairIndex = beginIndex; pairIndex < endIndex; pairIndex++)
+            {
+                CollectOverlappingPairs(nodePairs[pairIndex].first, nodePairs[pairIndex].second, [&](T objectA, T objectB)
+                {
+                    pairBuffers[pairIndex].emplace_back(objectA, objectB);
+                });
+            }
+        });
+
+        size_t pairCount = 0;
+        for (const std::vector<std::pair<T, T>>& pairBuffer : pairBuffers)
+        {
+            pairCount += pairBuffer.size();
+        }
+
+        overlappingPairs.reserve(pairCount);
+        for (const std::vector<std::pair<T, T>>& pairBuffer : pairBuffers)
+        {
+            overlappingPairs.insert(overlappingPairs.end(), pairBuffer.begin(), pairBuffer.end());
+        }
+    }
+
+    template <typename T, typename Traits>
+    template <typename Function>
+    T BVH<T, Traits>::FindNearest(const glm::vec3& point, Function distanceFunction, float maximumSquaredDistance) const
+    {
+        PriorityQueue<std::pair<float, T>> nearestObjects;
+        SearchNearest(point, 1, maximumSquaredDistance, distanceFunction, nearestObjects);
+
+        return nearestObjects.IsEmpty() ? m_Traits.GetNullObject() : nearestObjects.GetTop().second;
+    }
+
+    template <typename T, typename Traits>
+    template <typename Function>
+    void BVH<T, Traits>::FindKNearest(const glm::vec3& point, uint32_t neighbourCount, std::vector<T>& nearestObjects, Function distanceFunction, float maximumSquaredDistance) const
+    {
+        PriorityQueue<std::pair<float, T>> nearestCandidates;
+        SearchNearest(point, neighbourCount, maximumSquaredDistance, distanceFunction, nearestCandidates);
+
+        // The candidates come out furthest first.
+        nearestObjects.resize(nearestCandidates.GetSize());
+        for (size_t objectIndex = nearestObjects.size(); objectIndex > 0; objectIndex--)
+        {
+            nearestObjects[objectIndex - 1] = nearestCandidates.Pop().second;
+        }
+    }
+
+    template <typename T, typename Traits>
+    template <typename Function>
+    void BVH<T, Traits>::SearchNearest(const glm::vec3& point, uint32_t neighbourCount, float maximumSquaredDistance, Function distanceFunction, PriorityQueue<std::pair<float, T>>& nearestObjects) const
+    {
+        if (m_Root == nullptr || neighbourCount == 0)
+        {
+            return;
+        }
+
+        // Nearest objects are kept in a max heap of at most neighbourCount entries, so the current cut off distance is always at the top.
+        auto GetCutOffDistance = [&]()
+        {
+            return nearestObjects.GetSize() < neighbourCount ? maximumSquaredDistance : nearestObjects.GetTop().first;
+        };
+
+        // Nodes are visited closest box first. Once the closest remaining box lies beyond the cut off, nothing left can improve the result.
+        PriorityQueue<std::pair<float, const BVHNode*>, std::greater<std::pair<float, const BVHNode*>>> nodeQueue;
+        nodeQueue.Push({ m_Root->m_AABB.GetSquaredDistance(point), m_Root });
+
+        while (!nodeQueue.IsEmpty())
+        {
+            std::pair<float, const BVHNode*> nodeEntry = nodeQueue.Pop();
+            if (nodeEntry.first > GetCutOffDistance())
+            {
+                break;
+            }
+
+            if (nodeEntry.second->IsLeaf())
+            {
+                ForEachLeafObject(nodeEntry.second, [&](T currentObject)
+                {
+                    if (m_Traits.GetAABB(currentObject).GetSquaredDistance(point) > GetCutOffDistance())
+                    {
+                        return true;
+                    }
+
+                    const float objectDistance = distanceFunction(currentObject, point);
+                    if (objectDistance > maximumSquaredDistance)
+                    {
+                        return true;
+                    }
+
+                    if (nearestObjects.GetSize() < neighbourCount)
+                    {
+                        nearestObjects.Push({ objectDistance, currentObject });
+                    }
+                    else if (objectDistance < nearestObjects.GetTop().first)
+                    {
+                        nearestObjects.Pop();
+                        nearestObjects.Push({ objectDistance, currentObject });
+                    }
+
+                    return true;
+                });
+
+                continue;
+            }
+
+            for (int childIndex = 0; childIndex < 2; childIndex++)
+            {
+                const float childDistance = nodeEntry.second->m_Children[childIndex]->m_AABB.GetSquaredDistance(point);
+                if (childDistance <= GetCutOffDistance())
+                {
+                    nodeQueue.Push({ childDistance, nodeEntry.second->m_Children[childIndex] });
+                }
+            }
+        }
+    }
+
+    template <typename T, typename Traits>
+    template <typename U, typename OtherTraits, typename Function>
+    bool BVH<T, Traits>::QueryOverlappingPairs(const BVH<U, OtherTraits>& otherBVH, Function pairFunction) const
+    {
+        return CollectTreePairs(otherBVH, nullptr, pairFunction);
+    }
+
+    template <typename T, typename Traits>
+    template <typename U, typename OtherTraits, typename Function>
+    bool BVH<T, Traits>::QueryOverlappingPairs(const BVH<U, OtherTraits>& otherBVH, const glm::mat4& otherToThisTransform, Function pairFunction) const
+    {
+        return CollectTreePairs(otherBVH, &otherToThisTransform, pairFunction);
+    }
+
+    template <typename T, typename Traits>
+    template <typename U, typename OtherTraits, typename Function>
+    bool BVH<T, Traits>::CollectTreePairs(const BVH<U, OtherTraits>& otherBVH, const glm::mat4* otherToThisTransform, Function pairFunction) const
+    {
+        using OtherNode = typename BVH<U, OtherTraits>::BVHNode;
+
+        if (m_Root == nullptr || otherBVH.m_Root == nullptr)
+        {
+            return true;
+        }
+
+        // The other tree's boxes are brought into this tree's space as they are visited.
+        auto GetOtherAABB = [otherToThisTransform](const AABB& otherAABB)
+        {
+            return otherToThisTransform != nullptr ? otherAABB.Transform(*otherToThisTransform) : otherAABB;
+        };
+
+        TraversalStack<std::pair<const BVHNode*, const OtherNode*>> pairStack;
+        pairStack.Push({ m_Root, otherBVH.m_Root });
+        bool isRunning = true;
+
+        while (!pairStack.IsEmpty() && isRunning)
+        {
+            std::pair<const BVHNode*, const OtherNode*> nodePair = pairStack.Pop();
+            const BVHNode* thisNode = nodePair.first;
+            const OtherNode* otherNode = nodePair.second;
+            const AABB otherAABB = GetOtherAABB(otherNode->m_AABB);
+
+            if (!thisNode->m_AABB.Overlaps(otherAABB))
+            {
+                continue;
+            }
+
+            if (thisNode->IsLeaf() && otherNode->IsLeaf())
+            {
+                ForEachLeafObject(thisNode, [&](T thisObject)
+                {
+                    if (m_Traits.GetAABB(thisObject).Overlaps(otherAABB))
+                    {
+                        otherBVH.ForEachLeafObject(otherNode, [&](U otherObject)
+                        {
+                            if (m_Traits.GetAABB(thisObject).Overlaps(GetOtherAABB(otherBVH.m_Traits.GetAABB(otherObject))))
+                            {
+                                isRunning = pairFunction(thisObject, otherObject);
+                            }
+
+                            return isRunning;
+                        });
+                    }
+
+                    return isRunning;
+                });
+
+                continue;
+            }
+
+            // Always split the larger of the two nodes, which keeps the pairs being compared roughly equal in size.
+            if (otherNode->IsLeaf() || (!thisNode->IsLeaf() && thisNode->m_AABB.GetSurfaceArea() >= otherAABB.GetSurfaceArea()))
+            {
+                pairStack.Push({ thisNode->m_Children[1], otherNode });
+                pairStack.Push({ thisNode->m_Children[0], otherNode });
+            }
+            else
+            {
+                pairStack.Push({ thisNode, otherNode->m_Children[1] });
+                pairStack.Push({ thisNode, otherNode->m_Children[0] });
+            }
+        }
+
+        return isRunning;
+    }
+
+    template <typename T, typename Traits>
+    template <typename Function>
+    void BVH<T, Traits>::CollectOverlappingPairs(const BVHNode* nodeA, const BVHNode* nodeB, Function pairFunction) const
+    {
+        // Descends the tree against itself. A node paired with itself only needs its children paired with themselves and with each other, which
+        // visits every unordered pair of objects exactly once. Pairs of distinct nodes split the larger node until both are leafs.
+        TraversalStack<std::pair<const BVHNode*, const BVHNode*>> pairStack;
+        pairStack.Push({ nodeA, nodeB });
+
+        while (!pairStack.IsEmpty())
+        {
+            std::pair<const BVHNode*, const BVHNode*> nodePair = pairStack.Pop();
+            const BVHNode* firstNode = nodePair.first;
+            const BVHNode* secondNode = nodePair.second;
+
+            if (firstNode == secondNode)
+            {
+                if (firstNode->IsLeaf())
+                {
+                    uint32_t outerIndex = 0;
+                    ForEachLeafObject(firstNode, [&](T outerObject)
+                    {
+                        uint32_t innerIndex = 0;
+                        ForEachLeafObject(firstNode, [&](T innerObject)
+                        {
+                            if (innerIndex++ > outerIndex && m_Traits.GetAABB(outerObject).Overlaps(m_Traits.GetAABB(innerObject)))
+                            {
+                                pairFunction(outerObject, innerObject);
+                            }
+
+                            return true;
+                        });
+
+                        outerIndex++;
+                        return true;
+                    });
+                }
+                else
+                {
+                    pairStack.Push({ firstNode->m_Children[0], firstNode->m_Children[0] });
+                    pairStack.Push({ firstNode->m_Children[1], firstNode->m_Children[1] });
+
+                    if (firstNode->m_Children[0]->m_AABB.Overlaps(firstNode->m_Children[1]->m_AABB))
+                    {
+                        pairStack.Push({ firstNode->m_Children[0], firstNode->m_Children[1] });
+                    }
+                }
+
+                continue;
+            }
+
+            if (firstNode->IsLeaf() && secondNode->IsLeaf())
+            {
+                ForEachLeafObject(firstNode, [&](T firstObject)
+                {
+                    if (m_Traits.GetAABB(firstObject).Overlaps(secondNode->m_AABB))
+                    {
+                        ForEachLeafObject(secondNode, [&](T secondObject)
+                        {
+                            if (m_Traits.GetAABB(firstObject).Overlaps(m_Traits.GetAABB(secondObject)))
+                            {
+                                pairFunction(firstObject, secondObject);
+                            }
+
+                            return true;
+                        });
+                    }
+
+                    return true;
+                });
+
+                continue;
+            }
+
+            const bool splitFirst = secondNode->IsLeaf() || (!firstNode->IsLeaf() && firstNode->m_AABB.GetSurfaceArea() >= secondNode->m_AABB.GetSurfaceArea());
+            const BVHNode* splitNode = splitFirst ? firstNode : secondNode;
+            const BVHNode* otherNode = splitFirst ? secondNode : firstNode;
+
+            for (int childIndex = 0; childIndex < 2; childIndex++)
+            {
+                if (splitNode->m_Children[childIndex]->m_AABB.Overlaps(otherNode->m_AABB))
+                {
+                    pairStack.Push({ splitNode->m_Children[childIndex], otherNode });
+                }
+            }
+        }
+    }
+
+    template <typename T, typename Traits>
+    template <typename Function>
+    void BVH<T, Traits>::ForEachSubtreeObject(const BVHNode* subtreeRoot, Function objectFunction) const
+    {
+        TraversalStack<const BVHNode*> nodeStack;
+        nodeStack.Push(subtreeRoot);
+
+        while (!nodeStack.IsEmpty())
+        {
+            const BVHNode* currentNode = nodeStack.Pop();
+
+            if (currentNode->IsLeaf())
+            {
+                ForEachLeafObject(currentNode, [&](T currentObject) { objectFunction(currentObject); return true; });
+            }
+            else
+            {
+                nodeStack.Push(currentNode->m_Children[1]);
+                nodeStack.Push(currentNode->m_Children[0]);
+            }
+        }
+    }
+
+    template <typename T, typename Traits>
+    template <typename Function>
+    void BVH<T, Traits>::ForEachLeafObject(const BVHNode* leafNode, Function objectFunction) const
+    {
+        const T* leafObjects = m_Objects.data() + leafNode->m_FirstObject;
+        for (uint32_t objectIndex = 0; objectIndex < leafNode->m_ObjectCount; objectIndex++)
+        {
+            if (!objectFunction(leafObjects[objectIndex]))
+            {
+                return;
+            }
+        }
+    }
+
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::AssignLeafObjects(BVHNode* leafNode, uint32_t firstObject, uint32_t objectCount)
+    {
+        leafNode->m_FirstObject = firstObject;
+        leafNode->m_ObjectCount = objectCount;
+
+        for (uint32_t objectIndex = firstObject; objectIndex < firstObject + objectCount; objectIndex++)
+        {
+            leafNode->m_AABB.Expand(m_Traits.GetAABB(m_Objects[objectIndex]));
+            SetObjectNode(m_Objects[objectIndex], leafNode);
+        }
+    }
+
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::AppendLeafObject(BVHNode* leafNode, T targetObject)
+    {
+        // Compact before appending, as new leafs are only linked into the tree afterwards and would be skipped over.
+        if (m_StaleObjectCount > 64 && m_StaleObjectCount > m_Objects.size() / 2)
+        {
+            CompactObjects();
+        }
+
+        // Only the range at the very end of m_Objects can grow in place. Any other leaf moves its range there, leaving its old entries stale.
+        if (leafNode->m_ObjectCount == 0)
+        {
+            leafNode->m_FirstObject = (uint32_t)m_Objects.size();
+        }
+        else if (leafNode->m_FirstObject + leafNode->m_ObjectCount != m_Objects.size())
+        {
+            // Copied by index, as inserting a range of the vector into itself isn't allowed. Reserving up front keeps the copies from reallocating,
+            // while still growing geometrically.
+            const uint32_t firstObject = (uint32_t)m_Objects.size();
+            const size_t requiredCapacity = m_Objects.size() + leafNode->m_ObjectCount + 1;
+            if (requiredCapacity > m_Objects.capacity())
+            {
+                m_Objects.reserve(std::max(requiredCapacity, m_Objects.capacity() * 2));
+            }
+
+            for (uint32_t objectIndex = 0; objectIndex < leafNode->m_ObjectCount; objectIndex++)
+            {
+                m_Objects.push_back(m_Objects[leafNode->m_FirstObject + objectIndex]);
+            }
+
+            m_StaleObjectCount += leafNode->m_ObjectCount;
+            leafNode->m_FirstObject = firstObject;
+        }
+
+        m_Objects.push_back(targetObject);
+        leafNode->m_ObjectCount++;
+        leafNode->m_AABB.Expand(m_Traits.GetAABB(targetObject));
+        SetObjectNode(targetObject, leafNode);
+    }
+
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::CompactObjects()
+    {
+        std::vector<T> compactObjects;
+        compactObjects.reserve(m_ObjectCount);
+
+        if (m_Root != nullptr)
+        {
+            TraversalStack<BVHNode*> nodeStack;
+            nodeStack.Push(m_Root);
+
+            while (!nodeStack.IsEmpty())
+            {
+                BVHNode* node = nodeStack.Pop();
+                if (node->IsLeaf())
+                {
+                    const uint32_t firstObject = (uint32_t)compactObjects.size();
+                    compactObjects.insert(compactObjects.end(), m_Objects.begin() + node->m_FirstObject, m_Objects.begin() + node->m_FirstObject + node->m_ObjectCount);
+                    node->m_FirstObject = firstObject;
+                }
+                else
+                {
+                    nodeStack.Push(node->m_Children[1]);
+                    nodeStack.Push(node->m_Children[0]);
+                }
+            }
+        }
+
+        m_Objects = std::move(compactObjects);
+        m_StaleObjectCount = 0;
+    }
+
+    template <typename T, typename Traits>
+    void BVH<T, Traits>::SetObjectNode(T targetObject, BVHNode* leafNode) const
+    {
+        if constexpr (Traits::s_HasNodeStorage)
+        {
+            m_Traits.SetNode(targetObject, leafNode);
+        }
+    }
+
+    template <typename T, typename Traits>
+    bool BVH<T, Traits>::IsEmpty() const
+    {
+        return m_ObjectCount == 0;
+    }
+
+    template <typename T, typename Traits>
+    int BVH<T, Traits>::GetDepth() const
+    {
+        if (m_Root != nullptr)
+        {
+            return m_Root->GetDepth();
+        }
+
+        return -1;
+    }
+
+    // Returns the number of nodes in the tree.
+    template <typename T, typename Traits>
+    int BVH<T, Traits>::GetSize() const
+    {
+        if (m_Root != nullptr)
+        {
+            return m_Root->GetSize();
+        }
+
+        return 0;
+    }
+
+    template <typename T, typename Traits>
+    typename BVH<T, Traits>::BVHNode const* BVH<T, Traits>::GetRoot() const
+    {
+        return m_Root;
+    }
+
+    template <typename T, typename Traits>
+    AABB BVH<T, Traits>::CreateEncapsulatingBoundingVolume(const std::vector<T>& targetObjects, size_t beginIndex, size_t endIndex, ThreadPool* threadPool, size_t grainSize)
+    {
+        if (threadPool != nullptr && (endIndex - beginIndex) > grainSize)
+        {
+            // Each chunk bounds its own objects, and the chunk bounds are merged at the end.
+            std::vector<AABB> chunkBounds((endIndex - beginIndex + grainSize - 1) / grainSize);
+            threadPool->ParallelFor(beginIndex, endIndex, grainSize, [&](size_t chunkBegin, size_t chunkEnd)
+            {
+                chunkBounds[(chunkBegin - beginIndex) / grainSize] = CreateEncapsulatingBoundingVolume(targetObjects, chunkBegin, chunkEnd, nullptr, 0);
+            });
+
+            AABB aabb = chunkBounds[0];
+            for (size_t i = 1; i < chunkBounds.size(); ++i)
+            {
+                aabb.Expand(chunkBounds[i]);
+            }
+            return aabb;
+        }
+
+        AABB aabb = m_Traits.GetAABB(targetObjects[beginIndex]);
+        for (size_t i = beginIndex + 1; i < endIndex; ++i)
+        {
+            aabb.Expand(m_Traits.GetAABB(targetObjects[i]));
+        }
+        return aabb;
+    }
+
+    template <typename T, typename Traits>
+    ThreadPool* BVH<T, Traits>::AcquireThreadPool(uint32_t threadCount) const
+    {
+        threadCount = threadCount != 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+        if (threadCount <= 1)
+        {
+            return nullptr;
+        }
+
+        // Reuse the pool from the previous build unless the thread count changed.
+        if (m_ThreadPool == nullptr || m_ThreadPool->GetThreadCount() != threadCount)
+        {
+            m_ThreadPool = std::make_unique<ThreadPool>(threadCount);
+        }
+
+        return m_ThreadPool.get();
+    }
+
+    /// ====================================================
+
+    template <typename T, typename Traits>
+    BVH<T, Traits>::BVHNode::BVHNode() : m_FirstObject(0), m_ObjectCount(0), m_Children{ nullptr, nullptr }, m_Parent(nullptr)
+    {
+        m_AABB.m_Minimum = glm::vec3(std::numeric_limits<float>::max());
+        m_AABB.m_Maximum = glm::vec3(std::numeric_limits<float>::lowest());
+    }
+
+    template <typename T, typename Traits>
+    bool BVH<T, Traits>::BVHNode::IsLeaf() const
+    {
+        // Each node only has 2 children.
+        return m_Children[0] == nullptr && m_Children[1] == nullptr;
+    }
+
+    template <typename T, typename Traits>
+    int BVH<T, Traits>::BVHNode::GetSize() const
+    {
+        if (IsLeaf())
+        {
+            return 1;
+        }
+
+        int currentSize = 1; // Self
+
+        if (m_Children[0] != nullptr)
+        {
+            currentSize += m_Children[0]->GetSize();
+        }
+
+        if (m_Children[1] != nullptr)
+        {
+            currentSize += m_Children[1]->GetSize();
+        }
+
+        return currentSize;
+    }
+
+    // If there is only a single node in the tree, we should obtain a depth of 0.
+    template <typename T, typename Traits>
+    int BVH<T, Traits>::BVHNode::GetDepth() const
+    {
+        if (m_Children[0] == nullptr && m_Children[1] == nullptr)
+        {
+            return 0;
+        }
+
+        int leftDepth = m_Children[0] != nullptr ? m_Children[0]->GetDepth() : 0;
+        int rightDepth = m_Children[1] != nullptr ? m_Children[1]->GetDepth() : 0;
+
+        return 1 + std::max(leftDepth, rightDepth);
+    }
+
+    template <typename T, typename Traits>
+    uint32_t BVH<T, Traits>::BVHNode::GetObjectCount() const
+    {
+        // Remember that objects are only stored at the leaves.
+        return m_ObjectCount;
+    }
+
+    template <typename T, typename Traits>
     template <typename Function>
-    void BVH<T>::BVHNode::TraverseLevelOrder(Function traversalFunction) const
+    void BVH<T, Traits>::BVHNode::TraverseLevelOrder(Function traversalFunction) const
     {
         // We will perform BFS here.
         std::queue<const BVHNode*> nodeQueue;
@@ -750,7 +3152,7 @@ namespace Spatium
         {
             const BVHNode* currentNode = nodeQueue.front();
             nodeQueue.pop();
-            func(currentNode);
+            traversalFunction(currentNode);
 
             if (currentNode->m_Children[0] != nullptr)
             {
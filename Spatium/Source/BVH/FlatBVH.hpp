@@ -0,0 +1,55 @@
+#ifndef FLAT_BVH_HPP
+#define FLAT_BVH_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "BVH.hpp"
+#include "Core/TraversalStack.h"
+
+namespace Spatium
+{
+	// A read-only, index based copy of a BVH. Nodes are laid out depth-first in one array so a node's left child always sits right after it,
+	// and each leaf's objects are stored contiguously. Traversal then walks a couple of flat arrays instead of chasing node and object pointers.
+	template <typename T, typename Traits = BVHDefaultTraits<T>>
+	class FlatBVH
+	{
+	public:
+		struct FlatBVHNode
+		{
+		public:
+			bool IsLeaf() const { return m_Count > 0; }
+			uint32_t GetRightChild() const { return m_Offset; } // The left child always directly follows its parent.
+			uint32_t GetFirstObject() const { return m_Offset; }
+			uint32_t GetCount() const { return m_Count; }
+
+		public:
+			AABB m_AABB;
+			uint32_t m_Offset = 0; // Right child for internal nodes, first index into the objects for leafs.
+			uint32_t m_Count = 0; // Object count for leafs, 0 for internal nodes.
+		};
+
+		static_assert(sizeof(FlatBVHNode) == 32, "Flat nodes are expected to fit two to a 64 byte cache line.");
+
+	public:
+		void Build(const BVH<T, Traits>& sourceBVH); // Flattens the given tree. The source tree can be freely modified or destroyed afterwards.
+
+		template <typename Function>
+		void Query(const AABB& queryAABB, Function queryFunction) const; // Applies the function to all objects whose bounding box overlaps the given one.
+
+		void Clear();
+
+		bool IsEmpty() const { return m_Nodes.empty(); }
+		const std::vector<FlatBVHNode>& GetNodes() const { return m_Nodes; }
+		const std::vector<T>& GetObjects() const { return m_Objects; } // In leaf order.
+
+	private:
+		std::vector<FlatBVHNode> m_Nodes;
+		std::vector<T> m_Objects;
+		Traits m_Traits; // Copied from the source tree.
+	};
+}
+
+#include "FlatBVH.inl"
+
+#endif
@@ -0,0 +1,124 @@
+#include "FlatBVH.hpp"
+
+namespace Spatium
+{
+    template <typename T, typename Traits>
+    void FlatBVH<T, Traits>::Build(const BVH<T, Traits>& sourceBVH)
+    {
+        Clear();
+        m_Traits = sourceBVH.GetTraits();
+
+        const typename BVH<T, Traits>::BVHNode* rootNode = sourceBVH.GetRoot();
+        if (rootNode == nullptr)
+        {
+            return;
+        }
+
+        m_Nodes.reserve(sourceBVH.GetSize());
+        m_Objects.reserve(sourceBVH.GetObjectCount());
+
+        // Pre-order walk. Pushing the right child first means the left child is always emitted next, directly after its parent. The right
+        // child only gets an index once the whole left subtree has been written out, so it carries the index of the parent it needs to patch.
+        struct PendingNode
+        {
+            const typename BVH<T, Traits>::BVHNode* m_Node;
+            uint32_t m_ParentIndex;
+        };
+
+        const uint32_t noParent = std::numeric_limits<uint32_t>::max();
+        TraversalStack<PendingNode> pendingNodes;
+        pendingNodes.Push({ rootNode, noParent });
+
+        while (!pendingNodes.IsEmpty())
+        {
+            PendingNode pendingNode = pendingNodes.Pop();
+            const uint32_t nodeIndex = (uint32_t)m_Nodes.size();
+
+            if (pendingNode.m_ParentIndex != noParent)
+            {
+                m_Nodes[pendingNode.m_ParentIndex].m_Offset = nodeIndex;
+            }
+
+            FlatBVHNode flatNode;
+            flatNode.m_AABB = pendingNode.m_Node->m_AABB;
+
+            if (pendingNode.m_Node->IsLeaf())
+            {
+                flatNode.m_Offset = (uint32_t)m_Objects.size();
+
+                const auto leafObjects = sourceBVH.GetObjects().begin() + pendingNode.m_Node->m_FirstObject;
+                m_Objects.insert(m_Objects.end(), leafObjects, leafObjects + pendingNode.m_Node->m_ObjectCount);
+
+                flatNode.m_Count = (uint32_t)m_Objects.size() - flatNode.m_Offset;
+
+                // An empty leaf would read as an internal node, so give it a box that nothing can overlap and it is never entered.
+                if (flatNode.m_Count == 0)
+                {
+                    flatNode.m_AABB = AABB(glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()));
+                }
+
+                m_Nodes.push_back(flatNode);
+            }
+            else
+            {
+                m_Nodes.push_back(flatNode);
+                pendingNodes.Push({ pendingNode.m_Node->m_Children[1], nodeIndex });
+                pendingNodes.Push({ pendingNode.m_Node->m_Children[0], noParent });
+            }
+        }
+    }
+
+    template <typename T, typename Traits>
+    template <typename Function>
+    void FlatBVH<T, Traits>::Query(const AABB& queryAABB, Function queryFunction) const
+    {
+        if (m_Nodes.empty())
+        {
+            return;
+        }
+
+        TraversalStack<uint32_t> nodeStack;
+        uint32_t nodeIndex = 0;
+
+        while (true)
+        {
+            const FlatBVHNode& currentNode = m_Nodes[nodeIndex];
+
+            if (currentNode.m_AABB.Overlaps(queryAABB))
+            {
+                if (currentNode.IsLeaf())
+                {
+                    const uint32_t endIndex = currentNode.m_Offset + currentNode.m_Count;
+                    for (uint32_t objectIndex = currentNode.m_Offset; objectIndex < endIndex; objectIndex++)
+                    {
+                        if (m_Traits.GetAABB(m_Objects[objectIndex]).Overlaps(queryAABB))
+                        {
+                            queryFunction(m_Objects[objectIndex]);
+                        }
+                    }
+                }
+                else
+                {
+                    // Continue straight into the adjacent left child and come back for the right one later.
+                    nodeStack.Push(currentNode.m_Offset);
+                    nodeIndex++;
+                    continue;
+                }
+            }
+
+            if (nodeStack.IsEmpty())
+            {
+                break;
+            }
+
+            nodeIndex = nodeStack.Pop();
+        }
+    }
+
+    template <typename T, typename Traits>
+    void FlatBVH<T, Traits>::Clear()
+    {
+        m_Nodes.clear();
+        m_Objects.clear();
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef QUANTIZED_BVH_HPP
+#define QUANTIZED_BVH_HPP
+
+#include <cstdint>
+#include <vector>
+#include <type_traits>
+
+#include "BVH.hpp"
+#include "Core/TraversalStack.h"
+
+namespace Spatium
+{
+	// A compressed, read-only copy of a BVH for very large scenes. Each node stores its two children's boxes as 8 or 16-bit steps inwards from
+	// its own box, rounded outwards so the decoded boxes always contain the originals. Only the root box is kept in full precision, and every
+	// other box is decoded from its parent's on the way down.
+	template <typename T, typename QuantizedType = uint16_t, typename Traits = BVHDefaultTraits<T>>
+	class QuantizedBVH
+	{
+		static_assert(std::is_same<QuantizedType, uint8_t>::value || std::is_same<QuantizedType, uint16_t>::value, "Quantized BVHs store either 8 or 16-bit bounds.");
+
+	public:
+		static constexpr uint32_t s_LeafFlag = 0x80000000u; // Set on child references that point into the leafs rather than the nodes.
+
+		struct QuantizedBVHNode
+		{
+		public:
+			QuantizedType m_ChildMinimum[2][3]; // Steps up from this node's minimum.
+			QuantizedType m_ChildMaximum[2][3]; // Steps down from this node's maximum.
+			uint32_t m_Children[2]; // Node indices, or leaf indices when flagged with s_LeafFlag.
+		};
+
+		struct QuantizedBVHLeaf
+		{
+		public:
+			uint32_t m_FirstObject;
+			uint32_t m_ObjectCount;
+		};
+
+	public:
+		void Build(const BVH<T, Traits>& sourceBVH); // Compresses the given tree. The source tree can be freely modified or destroyed afterwards.
+
+		template <typename Function>
+		void Query(const AABB& queryAABB, Function queryFunction) const; // Applies the function to all objects whose bounding box overlaps the given one.
+
+		void Clear();
+
+		bool IsEmpty() const { return m_Objects.empty() && m_Nodes.empty(); }
+		size_t GetMemoryUsage() const; // In bytes, for the nodes and leafs only.
+		const std::vector<QuantizedBVHNode>& GetNodes() const { return m_Nodes; }
+		const std::vector<QuantizedBVHLeaf>& GetLeafs() const { return m_Leafs; }
+		const std::vector<T>& GetObjects() const { return m_Objects; } // In leaf order.
+
+	private:
+		AABB QuantizeChild(const AABB& parentAABB, const AABB& childAABB, QuantizedType* quantizedMinimum, QuantizedType* quantizedMaximum) const; // Returns the decoded child box.
+		static glm::vec3 ComputeStepSize(const AABB& parentAABB);
+		static AABB DecodeChild(const AABB& parentAABB, const glm::vec3& stepSize, const QuantizedType* quantizedMinimum, const QuantizedType* quantizedMaximum);
+		uint32_t AddLeaf(const BVH<T, Traits>& sourceBVH, const typename BVH<T, Traits>::BVHNode* sourceNode);
+
+	private:
+		std::vector<QuantizedBVHNode> m_Nodes;
+		std::vector<QuantizedBVHLeaf> m_Leafs;
+		std::vector<T> m_Objects;
+		Traits m_Traits; // Copied from the source tree.
+
+		AABB m_RootAABB;
+		uint32_t m_RootReference = 0;
+	};
+}
+
+#include "QuantizedBVH.inl"
+
+#endif
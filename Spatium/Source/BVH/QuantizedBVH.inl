@@ -0,0 +1,235 @@
+#include "QuantizedBVH.hpp"
+#include <cmath>
+
+namespace Spatium
+{
+    template <typename T, typename QuantizedType, typename Traits>
+    void QuantizedBVH<T, QuantizedType, Traits>::Build(const BVH<T, Traits>& sourceBVH)
+    {
+        Clear();
+        m_Traits = sourceBVH.GetTraits();
+
+        const typename BVH<T, Traits>::BVHNode* rootNode = sourceBVH.GetRoot();
+        if (rootNode == nullptr)
+        {
+            return;
+        }
+
+        m_Nodes.reserve(sourceBVH.GetSize() / 2);
+        m_Leafs.reserve(sourceBVH.GetSize() / 2 + 1);
+        m_Objects.reserve(sourceBVH.GetObjectCount());
+        m_RootAABB = rootNode->m_AABB;
+
+        if (rootNode->IsLeaf())
+        {
+            m_RootReference = AddLeaf(sourceBVH, rootNode);
+            return;
+        }
+
+        // Children are quantized against their parent's decoded box rather than its original one, as that is the box traversal will see.
+        struct PendingNode
+        {
+            const typename BVH<T, Traits>::BVHNode* m_Node;
+            uint32_t m_NodeIndex;
+            AABB m_DecodedAABB;
+        };
+
+        TraversalStack<PendingNode> pendingNodes;
+        m_RootReference = 0;
+        m_Nodes.emplace_back();
+        pendingNodes.Push({ rootNode, 0, m_RootAABB });
+
+        while (!pendingNodes.IsEmpty())
+        {
+            PendingNode pendingNode = pendingNodes.Pop();
+            QuantizedBVHNode quantizedNode;
+
+            for (int childIndex = 0; childIndex < 2; childIndex++)
+            {
+                const typename BVH<T, Traits>::BVHNode* childNode = pendingNode.m_Node->m_Children[childIndex];
+                AABB decodedAABB = QuantizeChild(pendingNode.m_DecodedAABB, childNode->m_AABB, quantizedNode.m_ChildMinimum[childIndex], quantizedNode.m_ChildMaximum[childIndex]);
+
+                if (childNode->IsLeaf())
+                {
+                    quantizedNode.m_Children[childIndex] = AddLeaf(sourceBVH, childNode);
+                }
+                else
+                {
+                    quantizedNode.m_Children[childIndex] = (uint32_t)m_Nodes.size();
+                    pendingNodes.Push({ childNode, (uint32_t)m_Nodes.size(), decodedAABB });
+                    m_Nodes.emplace_back();
+                }
+            }
+
+            m_Nodes[pendingNode.m_NodeIndex] = quantizedNode;
+        }
+    }
+
+    template <typename T, typename QuantizedType, typename Traits>
+    uint32_t QuantizedBVH<T, QuantizedType, Traits>::AddLeaf(const BVH<T, Traits>& sourceBVH, const typename BVH<T, Traits>::BVHNode* sourceNode)
+    {
+        QuantizedBVHLeaf quantizedLeaf;
+        quantizedLeaf.m_FirstObject = (uint32_t)m_Objects.size();
+        quantizedLeaf.m_ObjectCount = sourceNode->m_ObjectCount;
+
+        const auto leafObjects = sourceBVH.GetObjects().begin() + sourceNode->m_FirstObject;
+        m_Objects.insert(m_Objects.end(), leafObjects, leafObjects + sourceNode->m_ObjectCount);
+
+        m_Leafs.push_back(quantizedLeaf);
+
+        return ((uint32_t)m_Leafs.size() - 1) | s_LeafFlag;
+    }
+
+    template <typename T, typename QuantizedType, typename Traits>
+    glm::vec3 QuantizedBVH<T, QuantizedType, Traits>::ComputeStepSize(const AABB& parentAABB)
+    {
+        return (parentAABB.m_Maximum - parentAABB.m_Minimum) * (1.0f / (float)std::numeric_limits<QuantizedType>::max());
+    }
+
+    template <typename T, typename QuantizedType, typename Traits>
+    AABB QuantizedBVH<T, QuantizedType, Traits>::DecodeChild(const AABB& parentAABB, const glm::vec3& stepSize, const QuantizedType* quantizedMinimum, const QuantizedType* quantizedMaximum)
+    {
+        // Stepping inwards from both ends means a step of 0 reproduces the parent's bounds exactly.
+        return AABB(glm::vec3(parentAABB.m_Minimum.x + (float)quantizedMinimum[0] * stepSize.x, parentAABB.m_Minimum.y + (float)quantizedMinimum[1] * stepSize.y, parentAABB.m_Minimum.z + (float)quantizedMinimum[2] * stepSize.z),
+                    glm::vec3(parentAABB.m_Maximum.x - (float)quantizedMaximum[0] * stepSize.x, parentAABB.m_Maximum.y - (float)quantizedMaximum[1] * stepSize.y, parentAABB.m_Maximum.z - (float)quantizedMaximum[2] * stepSize.z));
+    }
+
+    template <typename T, typename QuantizedType, typename Traits>
+    AABB QuantizedBVH<T, QuantizedType, Traits>::QuantizeChild(const AABB& parentAABB, const AABB& childAABB, QuantizedType* quantizedMinimum, QuantizedType* quantizedMaximum) const
+    {
+        const float maximumSteps = (float)std::numeric_limits<QuantizedType>::max();
+        const glm::vec3 stepSize = ComputeStepSize(parentAABB);
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (stepSize[axis] <= 0.0f)
+            {
+                quantizedMinimum[axis] = 0;
+                quantizedMaximum[axis] = 0;
+                continue;
+            }
+
+            // Round both ends towards the parent's, which can only grow the child's box.
+            const float stepsUp = std::floor((childAABB.m_Minimum[axis] - parentAABB.m_Minimum[axis]) / stepSize[axis]);
+            const float stepsDown = std::floor((parentAABB.m_Maximum[axis] - childAABB.m_Maximum[axis]) / stepSize[axis]);
+
+            quantizedMinimum[axis] = (QuantizedType)std::min(std::max(stepsUp, 0.0f), maximumSteps);
+            quantizedMaximum[axis] = (QuantizedType)std::min(std::max(stepsDown, 0.0f), maximumSteps);
+        }
+
+        // Floating point error can still leave a decoded bound a hair inside the original. Step those back out until the decoded box, computed exactly
+        // as traversal will compute it, contains the child.
+        AABB decodedAABB = DecodeChild(parentAABB, stepSize, quantizedMinimum, quantizedMaximum);
+        bool isConservative = false;
+
+        while (!isConservative)
+        {
+            isConservative = true;
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (decodedAABB.m_Minimum[axis] > childAABB.m_Minimum[axis] && quantizedMinimum[axis] > 0)
+                {
+                    quantizedMinimum[axis]--;
+                    isConservative = false;
+                }
+
+                if (decodedAABB.m_Maximum[axis] < childAABB.m_Maximum[axis] && quantizedMaximum[axis] > 0)
+                {
+                    quantizedMaximum[axis]--;
+                    isConservative = false;
+                }
+            }
+
+            decodedAABB = DecodeChild(parentAABB, stepSize, quantizedMinimum, quantizedMaximum);
+        }
+
+        return decodedAABB;
+    }
+
+    template <typename T, typename QuantizedType, typename Traits>
+    template <typename Function>
+    void QuantizedBVH<T, QuantizedType, Traits>::Query(const AABB& queryAABB, Function queryFunction) const
+    {
+        if (m_Objects.empty() || !m_RootAABB.Overlaps(queryAABB))
+        {
+            return;
+        }
+
+        struct PendingReference
+        {
+            uint32_t m_Reference;
+            AABB m_DecodedAABB;
+        };
+
+        TraversalStack<PendingReference> referenceStack;
+        PendingReference currentReference = { m_RootReference, m_RootAABB };
+
+        while (true)
+        {
+            // References are only visited once their decoded box is known to overlap the query.
+            if (currentReference.m_Reference & s_LeafFlag)
+            {
+                const QuantizedBVHLeaf& currentLeaf = m_Leafs[currentReference.m_Reference & ~s_LeafFlag];
+                const uint32_t endIndex = currentLeaf.m_FirstObject + currentLeaf.m_ObjectCount;
+
+                for (uint32_t objectIndex = currentLeaf.m_FirstObject; objectIndex < endIndex; objectIndex++)
+                {
+                    if (m_Traits.GetAABB(m_Objects[objectIndex]).Overlaps(queryAABB))
+                    {
+                        queryFunction(m_Objects[objectIndex]);
+                    }
+                }
+            }
+            else
+            {
+                const QuantizedBVHNode& currentNode = m_Nodes[currentReference.m_Reference];
+                const glm::vec3 stepSize = ComputeStepSize(currentReference.m_DecodedAABB);
+                const AABB leftAABB = DecodeChild(currentReference.m_DecodedAABB, stepSize, currentNode.m_ChildMinimum[0], currentNode.m_ChildMaximum[0]);
+                const AABB rightAABB = DecodeChild(currentReference.m_DecodedAABB, stepSize, currentNode.m_ChildMinimum[1], currentNode.m_ChildMaximum[1]);
+                const bool leftOverlaps = leftAABB.Overlaps(queryAABB);
+                const bool rightOverlaps = rightAABB.Overlaps(queryAABB);
+
+                // Carry straight on into one of the children and only push the other, keeping the decoded box out of memory where possible.
+                if (leftOverlaps)
+                {
+                    if (rightOverlaps)
+                    {
+                        referenceStack.Push({ currentNode.m_Children[1], rightAABB });
+                    }
+
+                    currentReference = { currentNode.m_Children[0], leftAABB };
+                    continue;
+                }
+
+                if (rightOverlaps)
+                {
+                    currentReference = { currentNode.m_Children[1], rightAABB };
+                    continue;
+                }
+            }
+
+            if (referenceStack.IsEmpty())
+            {
+                break;
+            }
+
+            currentReference = referenceStack.Pop();
+        }
+    }
+
+    template <typename T, typename QuantizedType, typename Traits>
+    size_t QuantizedBVH<T, QuantizedType, Traits>::GetMemoryUsage() const
+    {
+        return m_Nodes.size() * sizeof(QuantizedBVHNode) + m_Leafs.size() * sizeof(QuantizedBVHLeaf);
+    }
+
+    template <typename T, typename QuantizedType, typename Traits>
+    void QuantizedBVH<T, QuantizedType, Traits>::Clear()
+    {
+        m_Nodes.clear();
+        m_Leafs.clear();
+        m_Objects.clear();
+        m_RootReference = 0;
+    }
+}
@@ -0,0 +1,589 @@
+#include "TriangleBVH.h"
+#include "Core/TraversalStack.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace Spatium
+{
+	namespace
+	{
+		AABB CreateEmptyAABB()
+		{
+			return AABB(glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()));
+		}
+
+		bool IsValidAABB(const AABB& aabb)
+		{
+			return aabb.m_Minimum.x <= aabb.m_Maximum.x && aabb.m_Minimum.y <= aabb.m_Maximum.y && aabb.m_Minimum.z <= aabb.m_Maximum.z;
+		}
+
+		float GetOverlapSurfaceArea(const AABB& a, const AABB& b)
+		{
+			AABB overlap(glm::max(a.m_Minimum, b.m_Minimum), glm::min(a.m_Maximum, b.m_Maximum));
+			return IsValidAABB(overlap) ? overlap.GetSurfaceArea() : 0.0f;
+		}
+	}
+
+	void TriangleBVH::Build(const std::vector<Triangle>& targetTriangles, const TriangleBVHConfiguration& treeConfiguration)
+	{
+		// Clear
+		m_Nodes.clear();
+		m_Indices.clear();
+		m_SpatialSplitCount = 0;
+
+		m_Configuration = treeConfiguration;
+
+		if (targetTriangles.empty())
+		{
+			return;
+		}
+
+		// Every triangle starts out with a single reference bounding all of it.
+		std::vector<TriangleReference> references(targetTriangles.size());
+		AABB rootAABB = CreateEmptyAABB();
+		for (size_t i = 0; i < targetTriangles.size(); i++)
+		{
+			references[i].m_AABB = AABB(targetTriangles[i].GetMinimumPoint(), targetTriangles[i].GetMaximumPoint());
+			references[i].m_TriangleIndex = static_cast<uint32_t>(i);
+			rootAABB.Expand(references[i].m_AABB);
+		}
+
+		m_RootSurfaceArea = rootAABB.GetSurfaceArea();
+		m_ReferenceCount = references.size();
+		m_MaximumReferenceCount = static_cast<size_t>(m_Configuration.m_MaximumReferenceFactor * static_cast<float>(references.size()));
+
+		// Create the root node and recursively build the tree.
+		m_Nodes.emplace_back();
+		BuildRecursive(targetTriangles, 0, references, 0);
+	}
+
+	void TriangleBVH::BuildRecursive(const std::vector<Triangle>& targetTriangles, uint32_t nodeIndex, std::vector<TriangleReference>& references, uint32_t currentDepth)
+	{
+		AABB nodeAABB = CreateEmptyAABB();
+		for (const TriangleReference& reference : references)
+		{
+			nodeAABB.Expand(reference.m_AABB);
+		}
+		m_Nodes[nodeIndex].m_AABB = nodeAABB;
+
+		auto CreateLeaf = [&]()
+		{
+			m_Nodes[nodeIndex].m_Offset = static_cast<uint32_t>(m_Indices.size());
+			m_Nodes[nodeIndex].m_Count = static_cast<uint32_t>(references.size());
+			for (const TriangleReference& reference : references)
+			{
+				m_Indices.push_back(reference.m_TriangleIndex);
+			}
+		};
+
+		// Check termination criteria.
+		if (references.size() <= m_Configuration.m_MaximumLeafTriangles || currentDepth >= m_Configuration.m_MaxDepth)
+		{
+			CreateLeaf();
+			return;
+		}
+
+		SplitCandidate objectSplit = FindObjectSplit(references, nodeAABB);
+
+		// Spatial splits are far more expensive to evaluate, so only consider them where the object split leaves the children overlapping noticeably.
+		// Measuring the overlap against the root rather than the node keeps spatial splits away from deep nodes, where they would save little.
+		SplitCandidate spatialSplit;
+		spatialSplit.m_Cost = std::numeric_limits<float>::max();
+		if (m_Configuration.m_UseSpatialSplits && m_ReferenceCount < m_MaximumReferenceCount)
+		{
+			float overlapArea = objectSplit.m_Axis != -1 ? GetOverlapSurfaceArea(objectSplit.m_LeftAABB, objectSplit.m_RightAABB) : m_RootSurfaceArea;
+			if (overlapArea > m_Configuration.m_OverlapThreshold * m_RootSurfaceArea)
+			{
+				spatialSplit = FindSpatialSplit(targetTriangles, references, nodeAABB);
+			}
+		}
+
+		// Splitting has to pay for itself against simply intersecting every reference in a leaf.
+		const bool useSpatialSplit = spatialSplit.m_Axis != -1 && spatialSplit.m_Cost < objectSplit.m_Cost;
+		const float bestCost = useSpatialSplit ? spatialSplit.m_Cost : objectSplit.m_Cost;
+		if (bestCost >= m_Configuration.m_IntersectionCost * static_cast<float>(references.size()))
+		{
+			CreateLeaf();
+			return;
+		}
+
+		std::vector<TriangleReference> leftReferences;
+		std::vector<TriangleReference> rightReferences;
+		if (useSpatialSplit)
+		{
+			PerformSpatialSplit(targetTriangles, references, spatialSplit, leftReferences, rightReferences);
+		}
+		else
+		{
+			PerformObjectSplit(references, objectSplit, leftReferences, rightReferences);
+		}
+
+		// No usable split could be found, such as when all references share the same centroid. Coincident triangles can also end up entirely
+		// on both sides of a spatial split, which would otherwise repeat at every level below.
+		if (leftReferences.empty() || rightReferences.empty() || (leftReferences.size() == references.size() && rightReferences.size() == references.size()))
+		{
+			CreateLeaf();
+			return;
+		}
+
+		if (useSpatialSplit)
+		{
+			m_ReferenceCount += leftReferences.size() + rightReferences.size() - references.size();
+			m_SpatialSplitCount++;
+		}
+
+		// The parent's references are no longer needed. Release them before descending.
+		std::vector<TriangleReference>().swap(references);
+
+		// Build the entire left subtree first, so that it directly follows its parent.
+		uint32_t leftChildIndex = static_cast<uint32_t>(m_Nodes.size());
+		m_Nodes.emplace_back();
+		BuildRecursive(targetTriangles, leftChildIndex, leftReferences, currentDepth + 1);
+
+		// After the entire left subtree is built, create the right child node.
+		uint32_t rightChildIndex = static_cast<uint32_t>(m_Nodes.size());
+		m_Nodes.emplace_back();
+		m_Nodes[nodeIndex].m_Offset = rightChildIndex;
+		BuildRecursive(targetTriangles, rightChildIndex, rightReferences, currentDepth + 1);
+	}
+
+	TriangleBVH::SplitCandidate TriangleBVH::FindObjectSplit(const std::vector<TriangleReference>& references, const AABB& nodeAABB)
+	{
+		SplitCandidate bestSplit;
+		bestSplit.m_Cost = std::numeric_limits<float>::max();
+
+		AABB centroidBounds = CreateEmptyAABB();
+		for (const TriangleReference& reference : references)
+		{
+			glm::vec3 center = reference.m_AABB.GetCenter();
+			centroidBounds.m_Minimum = glm::min(centroidBounds.m_Minimum, center);
+			centroidBounds.m_Maximum = glm::max(centroidBounds.m_Maximum, center);
+		}
+
+		const int binCount = static_cast<int>(std::max(m_Configuration.m_BinCount, 2u));
+		const float nodeSurfaceArea = std::max(nodeAABB.GetSurfaceArea(), std::numeric_limits<float>::min());
+
+		std::vector<AABB> binBounds(binCount);
+		std::vector<uint32_t> binCounts(binCount);
+		std::vector<AABB> rightBounds(binCount);
+		std::vector<uint32_t> rightCounts(binCount);
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float extent = centroidBounds.m_Maximum[axis] - centroidBounds.m_Minimum[axis];
+			if (extent <= 0.0f)
+			{
+				continue;
+			}
+
+			float binScale = static_cast<float>(binCount) / extent;
+			std::fill(binBounds.begin(), binBounds.end(), CreateEmptyAABB());
+			std::fill(binCounts.begin(), binCounts.end(), 0);
+
+			for (const TriangleReference& reference : references)
+			{
+				int binIndex = std::min(static_cast<int>((reference.m_AABB.GetCenter()[axis] - centroidBounds.m_Minimum[axis]) * binScale), binCount - 1);
+				binBounds[binIndex].Expand(reference.m_AABB);
+				binCounts[binIndex]++;
+			}
+
+			// Sweep from the right to gather everything right of each plane, then sweep from the left and evaluate each plane.
+			AABB accumulatedBounds = CreateEmptyAABB();
+			uint32_t accumulatedCount = 0;
+			for (int i = binCount - 1; i > 0; i--)
+			{
+				accumulatedBounds.Expand(binBounds[i]);
+				accumulatedCount += binCounts[i];
+				rightBounds[i] = accumulatedBounds;
+				rightCounts[i] = accumulatedCount;
+			}
+
+			accumulatedBounds = CreateEmptyAABB();
+			accumulatedCount = 0;
+			for (int i = 1; i < binCount; i++)
+			{
+				accumulatedBounds.Expand(binBounds[i - 1]);
+				accumulatedCount += binCounts[i - 1];
+
+				if (accumulatedCount == 0 || rightCounts[i] == 0)
+				{
+					continue;
+				}
+
+				float cost = m_Configuration.m_TraversalCost + m_Configuration.m_IntersectionCost * (accumulatedBounds.GetSurfaceArea() * accumulatedCount + rightBounds[i].GetSurfaceArea() * rightCounts[i]) / nodeSurfaceArea;
+				if (cost < bestSplit.m_Cost)
+				{
+					bestSplit.m_Cost = cost;
+					bestSplit.m_Axis = axis;
+					bestSplit.m_Position = centroidBounds.m_Minimum[axis];
+					bestSplit.m_BinScale = binScale;
+					bestSplit.m_Bin = static_cast<uint32_t>(i - 1);
+					bestSplit.m_LeftAABB = accumulatedBounds;
+					bestSplit.m_RightAABB = rightBounds[i];
+					bestSplit.m_LeftCount = accumulatedCount;
+					bestSplit.m_RightCount = rightCounts[i];
+				}
+			}
+		}
+
+		return bestSplit;
+	}
+
+	TriangleBVH::SplitCandidate TriangleBVH::FindSpatialSplit(const std::vector<Triangle>& targetTriangles, const std::vector<TriangleReference>& references, const AABB& nodeAABB)
+	{
+		SplitCandidate bestSplit;
+		bestSplit.m_Cost = std::numeric_limits<float>::max();
+
+		const int binCount = static_cast<int>(std::max(m_Configuration.m_BinCount, 2u));
+		const float nodeSurfaceArea = std::max(nodeAABB.GetSurfaceArea(), std::numeric_limits<float>::min());
+
+		std::vector<AABB> binBounds(binCount);
+		std::vector<uint32_t> entryCounts(binCount); // References starting in each bin.
+		std::vector<uint32_t> exitCounts(binCount); // References ending in each bin.
+		std::vector<AABB> rightBounds(binCount);
+		std::vector<uint32_t> rightCounts(binCount);
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			// Unlike object splits, spatial bins are uniform slabs of the node itself.
+			float axisMinimum = nodeAABB.m_Minimum[axis];
+			float binWidth = (nodeAABB.m_Maximum[axis] - axisMinimum) / static_cast<float>(binCount);
+			if (binWidth <= 0.0f)
+			{
+				continue;
+			}
+
+			std::fill(binBounds.begin(), binBounds.end(), CreateEmptyAABB());
+			std::fill(entryCounts.begin(), entryCounts.end(), 0);
+			std::fill(exitCounts.begin(), exitCounts.end(), 0);
+
+			for (const TriangleReference& reference : references)
+			{
+				int firstBin = std::min(std::max(static_cast<int>((reference.m_AABB.m_Minimum[axis] - axisMinimum) / binWidth), 0), binCount - 1);
+				int lastBin = std::min(std::max(static_cast<int>((reference.m_AABB.m_Maximum[axis] - axisMinimum) / binWidth), firstBin), binCount - 1);
+
+				// Chop the reference into the bins it spans, clipping the triangle against each bin boundary along the way.
+				TriangleReference remainingReference = reference;
+				for (int binIndex = firstBin; binIndex < lastBin; binIndex++)
+				{
+					TriangleReference leftReference;
+					TriangleReference rightReference;
+					SplitReference(targetTriangles[reference.m_TriangleIndex], remainingReference, axis, axisMinimum + binWidth * static_cast<float>(binIndex + 1), leftReference, rightReference);
+
+					binBounds[binIndex].Expand(leftReference.m_AABB);
+					remainingReference = rightReference;
+				}
+
+				binBounds[lastBin].Expand(remainingReference.m_AABB);
+				entryCounts[firstBin]++;
+				exitCounts[lastBin]++;
+			}
+
+			AABB accumulatedBounds = CreateEmptyAABB();
+			uint32_t accumulatedCount = 0;
+			for (int i = binCount - 1; i > 0; i--)
+			{
+				accumulatedBounds.Expand(binBounds[i]);
+				accumulatedCount += exitCounts[i];
+				rightBounds[i] = accumulatedBounds;
+				rightCounts[i] = accumulatedCount;
+			}
+
+			accumulatedBounds = CreateEmptyAABB();
+			accumulatedCount = 0;
+			for (int i = 1; i < binCount; i++)
+			{
+				accumulatedBounds.Expand(binBounds[i - 1]);
+				accumulatedCount += entryCounts[i - 1];
+
+				if (accumulatedCount == 0 || rightCounts[i] == 0 || !IsValidAABB(accumulatedBounds) || !IsValidAABB(rightBounds[i]))
+				{
+					continue;
+				}
+
+				// References straddling the plane are counted on both sides.
+				float cost = m_Configuration.m_TraversalCost + m_Configuration.m_IntersectionCost * (accumulatedBounds.GetSurfaceArea() * accumulatedCount + rightBounds[i].GetSurfaceArea() * rightCounts[i]) / nodeSurfaceArea;
+				if (cost < bestSplit.m_Cost)
+				{
+					bestSplit.m_Cost = cost;
+					bestSplit.m_Axis = axis;
+					bestSplit.m_Position = axisMinimum + binWidth * static_cast<float>(i);
+					bestSplit.m_LeftAABB = accumulatedBounds;
+					bestSplit.m_RightAABB = rightBounds[i];
+					bestSplit.m_LeftCount = accumulatedCount;
+					bestSplit.m_RightCount = rightCounts[i];
+				}
+			}
+		}
+
+		return bestSplit;
+	}
+
+	void TriangleBVH::PerformObjectSplit(const std::vector<TriangleReference>& references, const SplitCandidate& split, std::vector<TriangleReference>& leftReferences, std::vector<TriangleReference>& rightReferences)
+	{
+		leftReferences.reserve(split.m_LeftCount);
+		rightReferences.reserve(split.m_RightCount);
+
+		const int binCount = static_cast<int>(std::max(m_Configuration.m_BinCount, 2u));
+		for (const TriangleReference& reference : references)
+		{
+			// Same mapping as during binning, so that every reference lands on the side it was counted on.
+			int binIndex = std::min(static_cast<int>((reference.m_AABB.GetCenter()[split.m_Axis] - split.m_Position) * split.m_BinScale), binCount - 1);
+			if (binIndex <= static_cast<int>(split.m_Bin))
+			{
+				leftReferences.push_back(reference);
+			}
+			else
+			{
+				rightReferences.push_back(reference);
+			}
+		}
+	}
+
+	void TriangleBVH::PerformSpatialSplit(const std::vector<Triangle>& targetTriangles, const std::vector<TriangleReference>& references, const SplitCandidate& split, std::vector<TriangleReference>& leftReferences, std::vector<TriangleReference>& rightReferences)
+	{
+		leftReferences.reserve(split.m_LeftCount);
+		rightReferences.reserve(split.m_RightCount);
+
+		const int axis = split.m_Axis;
+		AABB leftAABB = split.m_LeftAABB;
+		AABB rightAABB = split.m_RightAABB;
+		float leftCount = static_cast<float>(split.m_LeftCount);
+		float rightCount = static_cast<float>(split.m_RightCount);
+
+		for (const TriangleReference& reference : references)
+		{
+			if (reference.m_AABB.m_Maximum[axis] <= split.m_Position)
+			{
+				leftReferences.push_back(reference);
+				continue;
+			}
+
+			if (reference.m_AABB.m_Minimum[axis] >= split.m_Position)
+			{
+				rightReferences.push_back(reference);
+				continue;
+			}
+
+			// Reference unsplitting: a straddling reference may be cheaper to keep whole on one side than to duplicate on both.
+			float splitCost = leftAABB.GetSurfaceArea() * leftCount + rightAABB.GetSurfaceArea() * rightCount;
+			float leftOnlyCost = leftAABB.Union(reference.m_AABB).GetSurfaceArea() * leftCount + rightAABB.GetSurfaceArea() * (rightCount - 1.0f);
+			float rightOnlyCost = leftAABB.GetSurfaceArea() * (leftCount - 1.0f) + rightAABB.Union(reference.m_AABB).GetSurfaceArea() * rightCount;
+
+			if (leftOnlyCost < splitCost && leftOnlyCost <= rightOnlyCost)
+			{
+				leftAABB.Expand(reference.m_AABB);
+				rightCount -= 1.0f;
+				leftReferences.push_back(reference);
+			}
+			else if (rightOnlyCost < splitCost)
+			{
+				rightAABB.Expand(reference.m_AABB);
+				leftCount -= 1.0f;
+				rightReferences.push_back(reference);
+			}
+			else
+			{
+				TriangleReference leftReference;
+				TriangleReference rightReference;
+				SplitReference(targetTriangles[reference.m_TriangleIndex], reference, axis, split.m_Position, leftReference, rightReference);
+
+				// Clipping may leave nothing on one side when the triangle merely touches the plane.
+				if (IsValidAABB(leftReference.m_AABB))
+				{
+					leftReferences.push_back(leftReference);
+				}
+
+				if (IsValidAABB(rightReference.m_AABB))
+				{
+					rightReferences.push_back(rightReference);
+				}
+			}
+		}
+	}
+
+	void TriangleBVH::SplitReference(const Triangle& triangle, const TriangleReference& reference, int axis, float position, TriangleReference& leftReference, TriangleReference& rightReference) const
+	{
+		leftReference.m_TriangleIndex = reference.m_TriangleIndex;
+		rightReference.m_TriangleIndex = reference.m_TriangleIndex;
+		leftReference.m_AABB = CreateEmptyAABB();
+		rightReference.m_AABB = CreateEmptyAABB();
+
+		// Walk the triangle's edges, sorting vertices to their side of the plane and adding edge/plane intersections to both sides.
+		for (int i = 0; i < 3; i++)
+		{
+			const glm::vec3& startPoint = triangle[i];
+			const glm::vec3& endPoint = triangle[(i + 1) % 3];
+			float start = startPoint[axis];
+			float end = endPoint[axis];
+
+			if (start <= position)
+			{
+				leftReference.m_AABB.Expand(AABB(startPoint, startPoint));
+			}
+
+			if (start >= position)
+			{
+				rightReference.m_AABB.Expand(AABB(startPoint, startPoint));
+			}
+
+			if ((start < position && end > position) || (start > position && end < position))
+			{
+				glm::vec3 intersection = glm::mix(startPoint, endPoint, glm::clamp((position - start) / (end - start), 0.0f, 1.0f));
+				intersection[axis] = position;
+
+				leftReference.m_AABB.Expand(AABB(intersection, intersection));
+				rightReference.m_AABB.Expand(AABB(intersection, intersection));
+			}
+		}
+
+		// The reference may already have been clipped by earlier splits, so the new parts must not grow past it.
+		leftReference.m_AABB.m_Maximum[axis] = std::min(leftReference.m_AABB.m_Maximum[axis], position);
+		rightReference.m_AABB.m_Minimum[axis] = std::max(rightReference.m_AABB.m_Minimum[axis], position);
+		leftReference.m_AABB = AABB(glm::max(leftReference.m_AABB.m_Minimum, reference.m_AABB.m_Minimum), glm::min(leftReference.m_AABB.m_Maximum, reference.m_AABB.m_Maximum));
+		rightReference.m_AABB = AABB(glm::max(rightReference.m_AABB.m_Minimum, reference.m_AABB.m_Minimum), glm::min(rightReference.m_AABB.m_Maximum, reference.m_AABB.m_Maximum));
+	}
+
+	bool TriangleBVH::IntersectClosest(const std::vector<Triangle>& targetTriangles, const Ray& ray, float& hitDistance, uint32_t& triangleIndex) const
+	{
+		if (m_Nodes.empty())
+		{
+			return false;
+		}
+
+		bool isHit = false;
+		TraversalStack<uint32_t> nodeStack;
+		nodeStack.Push(0);
+		while (!nodeStack.IsEmpty())
+		{
+			const uint32_t nodeIndex = nodeStack.Pop();
+			const TriangleBVHNode& node = m_Nodes[nodeIndex];
+
+			float entryDistance;
+			if (!node.m_AABB.IntersectRay(ray, hitDistance, entryDistance))
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = node.GetFirstIndex(); i < node.GetFirstIndex() + node.GetCount(); i++)
+				{
+					if (targetTriangles[m_Indices[i]].IntersectRay(ray, hitDistance, hitDistance))
+					{
+						triangleIndex = m_Indices[i];
+						isHit = true;
+					}
+				}
+
+				continue;
+			}
+
+			// Visit the nearer child first so that its hits can cull the farther one.
+			uint32_t nearChild = nodeIndex + 1;
+			uint32_t farChild = node.GetRightChild();
+			float nearDistance = std::numeric_limits<float>::max();
+			float farDistance = std::numeric_limits<float>::max();
+			m_Nodes[nearChild].m_AABB.IntersectRay(ray, hitDistance, nearDistance);
+			m_Nodes[farChild].m_AABB.IntersectRay(ray, hitDistance, farDistance);
+
+			if (farDistance < nearDistance)
+			{
+				std::swap(nearChild, farChild);
+			}
+
+			nodeStack.Push(farChild);
+			nodeStack.Push(nearChild);
+		}
+
+		return isHit;
+	}
+
+	bool TriangleBVH::IntersectAny(const std::vector<Triangle>& targetTriangles, const Ray& ray, float maximumDistance) const
+	{
+		if (m_Nodes.empty())
+		{
+			return false;
+		}
+
+		TraversalStack<uint32_t> nodeStack;
+		nodeStack.Push(0);
+		while (!nodeStack.IsEmpty())
+		{
+			const uint32_t nodeIndex = nodeStack.Pop();
+			const TriangleBVHNode& node = m_Nodes[nodeIndex];
+
+			float entryDistance;
+			if (!node.m_AABB.IntersectRay(ray, maximumDistance, entryDistance))
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = node.GetFirstIndex(); i < node.GetFirstIndex() + node.GetCount(); i++)
+				{
+					float hitDistance;
+					if (targetTriangles[m_Indices[i]].IntersectRay(ray, maximumDistance, hitDistance))
+					{
+						return true;
+					}
+				}
+
+				continue;
+			}
+
+			nodeStack.Push(node.GetRightChild());
+			nodeStack.Push(nodeIndex + 1);
+		}
+
+		return false;
+	}
+
+	void TriangleBVH::Query(const std::vector<Triangle>& targetTriangles, const AABB& queryAABB, std::vector<uint32_t>& triangleIndices) const
+	{
+		triangleIndices.clear();
+		if (m_Nodes.empty())
+		{
+			return;
+		}
+
+		TraversalStack<uint32_t> nodeStack;
+		nodeStack.Push(0);
+		while (!nodeStack.IsEmpty())
+		{
+			const uint32_t nodeIndex = nodeStack.Pop();
+			const TriangleBVHNode& node = m_Nodes[nodeIndex];
+
+			if (!node.m_AABB.Overlaps(queryAABB))
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = node.GetFirstIndex(); i < node.GetFirstIndex() + node.GetCount(); i++)
+				{
+					const Triangle& triangle = targetTriangles[m_Indices[i]];
+					if (AABB(triangle.GetMinimumPoint(), triangle.GetMaximumPoint()).Overlaps(queryAABB))
+					{
+						triangleIndices.push_back(m_Indices[i]);
+					}
+				}
+
+				continue;
+			}
+
+			nodeStack.Push(node.GetRightChild());
+			nodeStack.Push(nodeIndex + 1);
+		}
+
+		// Spatial splits reference straddling triangles from more than one leaf.
+		if (m_SpatialSplitCount > 0)
+		{
+			std::sort(triangleIndices.begin(), triangleIndices.end());
+			triangleIndices.erase(std::unique(triangleIndices.begin(), triangleIndices.end()), triangleIndices.end());
+		}
+	}
+}
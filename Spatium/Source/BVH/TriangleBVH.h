@@ -0,0 +1,92 @@
+#pragma once
+#include "Core/Geometry.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace Spatium
+{
+	struct TriangleBVHConfiguration
+	{
+		float m_TraversalCost = 1.0f;
+		float m_IntersectionCost = 1.0f;
+		uint32_t m_MaxDepth = 64;
+		uint32_t m_MaximumLeafTriangles = 4; // Nodes with this many triangle references or fewer become leaves.
+		uint32_t m_BinCount = 32; // Bins per axis, used for both object and spatial splits.
+
+		bool m_UseSpatialSplits = true;
+		float m_OverlapThreshold = 1e-5f; // Spatial splits are only tried when the object split's children overlap by more than this fraction of the root's surface area.
+		float m_MaximumReferenceFactor = 4.0f; // Spatial splits stop once there are this many times more references than triangles.
+	};
+
+	// A BVH over triangles that weighs regular object splits against spatial splits (SBVH). Spatial splits clip the triangles straddling the
+	// split plane and reference them from both sides, trading a few duplicate references for far less overlap between siblings.
+	class TriangleBVH
+	{
+	public:
+		struct TriangleBVHNode
+		{
+		public:
+			bool IsLeaf() const { return m_Count > 0; }
+			uint32_t GetRightChild() const { return m_Offset; } // The left child always directly follows its parent.
+			uint32_t GetFirstIndex() const { return m_Offset; }
+			uint32_t GetCount() const { return m_Count; }
+
+		public:
+			AABB m_AABB;
+			uint32_t m_Offset = 0; // Right child for internal nodes, first index into the triangle indices for leafs.
+			uint32_t m_Count = 0; // Triangle reference count for leafs, 0 for internal nodes.
+		};
+
+		void Build(const std::vector<Triangle>& targetTriangles, const TriangleBVHConfiguration& treeConfiguration);
+
+		// Queries take the same triangles the tree was built from.
+		bool IntersectClosest(const std::vector<Triangle>& targetTriangles, const Ray& ray, float& hitDistance, uint32_t& triangleIndex) const; // Lowers hitDistance on hits.
+		bool IntersectAny(const std::vector<Triangle>& targetTriangles, const Ray& ray, float maximumDistance) const;
+		void Query(const std::vector<Triangle>& targetTriangles, const AABB& queryAABB, std::vector<uint32_t>& triangleIndices) const; // Triangles whose bounds overlap the box, each listed once.
+
+		// Getters
+		const std::vector<TriangleBVHNode>& GetNodes() const { return m_Nodes; }
+		const std::vector<uint32_t>& GetIndices() const { return m_Indices; }
+		uint32_t GetSpatialSplitCount() const { return m_SpatialSplitCount; }
+		bool IsEmpty() const { return m_Nodes.empty(); }
+
+	private:
+		// A triangle as seen by one node. Its bounds shrink to the part of the triangle that lies within the node once it has been split spatially.
+		struct TriangleReference
+		{
+			AABB m_AABB;
+			uint32_t m_TriangleIndex;
+		};
+
+		struct SplitCandidate
+		{
+			float m_Cost;
+			int m_Axis = -1;
+			float m_Position = 0.0f; // Split plane for spatial splits, first centroid bin boundary for object splits.
+			float m_BinScale = 0.0f; // Object splits only. Maps centroids relative to m_Position onto bins.
+			uint32_t m_Bin = 0; // Object splits only. Last bin on the left.
+			AABB m_LeftAABB;
+			AABB m_RightAABB;
+			uint32_t m_LeftCount = 0;
+			uint32_t m_RightCount = 0;
+		};
+
+		void BuildRecursive(const std::vector<Triangle>& targetTriangles, uint32_t nodeIndex, std::vector<TriangleReference>& references, uint32_t currentDepth);
+		SplitCandidate FindObjectSplit(const std::vector<TriangleReference>& references, const AABB& nodeAABB);
+		SplitCandidate FindSpatialSplit(const std::vector<Triangle>& targetTriangles, const std::vector<TriangleReference>& references, const AABB& nodeAABB);
+		void PerformObjectSplit(const std::vector<TriangleReference>& references, const SplitCandidate& split, std::vector<TriangleReference>& leftReferences, std::vector<TriangleReference>& rightReferences);
+		void PerformSpatialSplit(const std::vector<Triangle>& targetTriangles, const std::vector<TriangleReference>& references, const SplitCandidate& split, std::vector<TriangleReference>& leftReferences, std::vector<TriangleReference>& rightReferences);
+		void SplitReference(const Triangle& triangle, const TriangleReference& reference, int axis, float position, TriangleReference& leftReference, TriangleReference& rightReference) const;
+
+	private:
+		std::vector<TriangleBVHNode> m_Nodes; // Depth first order.
+		std::vector<uint32_t> m_Indices; // Triangle indices in leaf order (may contain duplicates).
+		TriangleBVHConfiguration m_Configuration;
+
+		float m_RootSurfaceArea = 0.0f;
+		uint32_t m_SpatialSplitCount = 0;
+		size_t m_ReferenceCount = 0; // References across all leaves and pending nodes during a build.
+		size_t m_MaximumReferenceCount = 0;
+	};
+}
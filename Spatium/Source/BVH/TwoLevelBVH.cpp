@@ -0,0 +1,128 @@
+#include "TwoLevelBVH.h"
+
+namespace Spatium
+{
+	uint32_t TwoLevelBVH::AddMesh(const std::vector<Triangle>& meshTriangles, const TriangleBVHConfiguration& treeConfiguration)
+	{
+		m_Meshes.emplace_back();
+		m_Meshes.back().m_Triangles = meshTriangles;
+		m_Meshes.back().m_BVH.Build(m_Meshes.back().m_Triangles, treeConfiguration);
+
+		return static_cast<uint32_t>(m_Meshes.size()) - 1;
+	}
+
+	uint32_t TwoLevelBVH::AddInstance(uint32_t meshIndex, const glm::mat4& worldMatrix)
+	{
+		m_Instances.emplace_back();
+
+		TwoLevelInstance& instance = m_Instances.back();
+		instance.m_InstanceIndex = static_cast<uint32_t>(m_Instances.size()) - 1;
+		instance.m_MeshIndex = meshIndex;
+		instance.m_WorldMatrix = worldMatrix;
+		instance.m_InverseWorldMatrix = glm::inverse(worldMatrix);
+		UpdateInstanceAABB(instance);
+
+		return instance.m_InstanceIndex;
+	}
+
+	void TwoLevelBVH::SetInstanceTransform(uint32_t instanceIndex, const glm::mat4& worldMatrix)
+	{
+		TwoLevelInstance& instance = m_Instances[instanceIndex];
+		instance.m_WorldMatrix = worldMatrix;
+		instance.m_InverseWorldMatrix = glm::inverse(worldMatrix);
+		UpdateInstanceAABB(instance);
+	}
+
+	void TwoLevelBVH::Build(const BVHBuildConfiguration& buildConfiguration)
+	{
+		std::vector<TwoLevelInstance*> instancePointers;
+		instancePointers.reserve(m_Instances.size());
+		for (TwoLevelInstance& instance : m_Instances)
+		{
+			instancePointers.push_back(&instance);
+		}
+
+		m_TopLevel.BuildTopDown(instancePointers.begin(), instancePointers.end(), buildConfiguration);
+	}
+
+	float TwoLevelBVH::Refit(uint32_t threadCount)
+	{
+		return m_TopLevel.Refit(threadCount);
+	}
+
+	bool TwoLevelBVH::IntersectClosest(const Ray& ray, float maximumDistance, TwoLevelHit& closestHit) const
+	{
+		float hitDistance = maximumDistance;
+		uint32_t hitTriangle = 0;
+
+		const TwoLevelInstance* hitInstance = m_TopLevel.IntersectClosest(ray, hitDistance, [&](TwoLevelInstance* instance, float& instanceHitDistance)
+		{
+			const Mesh& mesh = m_Meshes[instance->m_MeshIndex];
+			return mesh.m_BVH.IntersectClosest(mesh.m_Triangles, TransformRay(ray, instance->m_InverseWorldMatrix), instanceHitDistance, hitTriangle);
+		});
+
+		if (hitInstance == nullptr)
+		{
+			return false;
+		}
+
+		// hitTriangle is only ever written by closer hits, so it belongs to the closest instance.
+		closestHit.m_InstanceIndex = hitInstance->m_InstanceIndex;
+		closestHit.m_TriangleIndex = hitTriangle;
+		closestHit.m_Distance = hitDistance;
+		return true;
+	}
+
+	bool TwoLevelBVH::IntersectAny(const Ray& ray, float maximumDistance) const
+	{
+		return m_TopLevel.IntersectAny(ray, maximumDistance, [&](TwoLevelInstance* instance, float& instanceMaximumDistance)
+		{
+			const Mesh& mesh = m_Meshes[instance->m_MeshIndex];
+			return mesh.m_BVH.IntersectAny(mesh.m_Triangles, TransformRay(ray, instance->m_InverseWorldMatrix), instanceMaximumDistance);
+		});
+	}
+
+	void TwoLevelBVH::Query(const AABB& queryAABB, std::vector<std::pair<uint32_t, uint32_t>>& instanceTriangles) const
+	{
+		instanceTriangles.clear();
+		std::vector<uint32_t> triangleIndices;
+
+		m_TopLevel.Query(queryAABB, [&](TwoLevelInstance* instance)
+		{
+			// The box around the query in object space is larger than the query itself once rotated, so candidates are checked again in world space.
+			const Mesh& mesh = m_Meshes[instance->m_MeshIndex];
+			mesh.m_BVH.Query(mesh.m_Triangles, queryAABB.Transform(instance->m_InverseWorldMatrix), triangleIndices);
+
+			for (uint32_t triangleIndex : triangleIndices)
+			{
+				const Triangle& triangle = mesh.m_Triangles[triangleIndex];
+				const glm::vec3 pointA = glm::vec3(instance->m_WorldMatrix * glm::vec4(triangle.m_Points[0], 1.0f));
+				const glm::vec3 pointB = glm::vec3(instance->m_WorldMatrix * glm::vec4(triangle.m_Points[1], 1.0f));
+				const glm::vec3 pointC = glm::vec3(instance->m_WorldMatrix * glm::vec4(triangle.m_Points[2], 1.0f));
+
+				if (AABB(glm::min(glm::min(pointA, pointB), pointC), glm::max(glm::max(pointA, pointB), pointC)).Overlaps(queryAABB))
+				{
+					instanceTriangles.emplace_back(instance->m_InstanceIndex, triangleIndex);
+				}
+			}
+		});
+	}
+
+	Ray TwoLevelBVH::TransformRay(const Ray& ray, const glm::mat4& transform)
+	{
+		return Ray(glm::vec3(transform * glm::vec4(ray.m_Origin, 1.0f)), glm::vec3(transform * glm::vec4(ray.m_Direction, 0.0f)));
+	}
+
+	void TwoLevelBVH::UpdateInstanceAABB(TwoLevelInstance& instance) const
+	{
+		const TriangleBVH& meshBVH = m_Meshes[instance.m_MeshIndex].m_BVH;
+		if (meshBVH.IsEmpty())
+		{
+			// Nothing can hit an empty mesh, so give it a box that nothing overlaps.
+			instance.m_AABB = AABB(glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()));
+			return;
+		}
+
+		instance.m_AABB = meshBVH.GetNodes()[0].m_AABB.Transform(instance.m_WorldMatrix);
+	}
+}
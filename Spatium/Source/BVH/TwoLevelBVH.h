@@ -0,0 +1,70 @@
+#pragma once
+#include "BVH.hpp"
+#include "TriangleBVH.h"
+
+#include <vector>
+#include <deque>
+#include <cstdint>
+
+namespace Spatium
+{
+	// One placement of a mesh in the world. Its world space box bounds the mesh's transformed bottom level root.
+	struct TwoLevelInstance
+	{
+		uint32_t m_InstanceIndex;
+		uint32_t m_MeshIndex;
+		glm::mat4 m_WorldMatrix;
+		glm::mat4 m_InverseWorldMatrix;
+		AABB m_AABB;
+	};
+
+	struct TwoLevelHit
+	{
+		uint32_t m_InstanceIndex = 0;
+		uint32_t m_TriangleIndex = 0;
+		float m_Distance = 0.0f;
+	};
+
+	// A top level BVH over instances, each of which points at one of a set of shared meshes with a triangle BVH of their own. Queries are taken
+	// into each instance's object space rather than the meshes into world space, so every mesh is built once however often it is placed, and
+	// moving instances around only calls for a top level refit.
+	class TwoLevelBVH
+	{
+	public:
+		uint32_t AddMesh(const std::vector<Triangle>& meshTriangles, const TriangleBVHConfiguration& treeConfiguration); // Builds its bottom level right away. Returns the mesh index.
+		uint32_t AddInstance(uint32_t meshIndex, const glm::mat4& worldMatrix); // Returns the instance index. Takes effect on the next Build().
+		void SetInstanceTransform(uint32_t instanceIndex, const glm::mat4& worldMatrix); // Takes effect on the next Refit() or Build().
+
+		void Build(const BVHBuildConfiguration& buildConfiguration); // Rebuilds the top level over all instances.
+		float Refit(uint32_t threadCount = 1); // Refits the top level to moved instances. Returns its SAH cost relative to the last Build().
+
+		bool IntersectClosest(const Ray& ray, float maximumDistance, TwoLevelHit& closestHit) const;
+		bool IntersectAny(const Ray& ray, float maximumDistance) const;
+
+		// Finds pairs of instance and triangle indices for triangles that may overlap the box. A triangle must pass a bounds test in object space
+		// and again in world space, so nothing that actually touches the box is missed.
+		void Query(const AABB& queryAABB, std::vector<std::pair<uint32_t, uint32_t>>& instanceTriangles) const;
+
+		// Getters
+		const BVH<TwoLevelInstance*>& GetTopLevel() const { return m_TopLevel; }
+		const TriangleBVH& GetMeshBVH(uint32_t meshIndex) const { return m_Meshes[meshIndex].m_BVH; }
+		const TwoLevelInstance& GetInstance(uint32_t instanceIndex) const { return m_Instances[instanceIndex]; }
+		uint32_t GetMeshCount() const { return static_cast<uint32_t>(m_Meshes.size()); }
+		uint32_t GetInstanceCount() const { return static_cast<uint32_t>(m_Instances.size()); }
+
+	private:
+		struct Mesh
+		{
+			std::vector<Triangle> m_Triangles;
+			TriangleBVH m_BVH;
+		};
+
+		static Ray TransformRay(const Ray& ray, const glm::mat4& transform); // Leaves the direction unnormalized, so distances along the ray carry over unchanged.
+		void UpdateInstanceAABB(TwoLevelInstance& instance) const;
+
+	private:
+		std::vector<Mesh> m_Meshes;
+		std::deque<TwoLevelInstance> m_Instances; // Instances never move once added, as the top level points straight at them.
+		BVH<TwoLevelInstance*> m_TopLevel;
+	};
+}
@@ -0,0 +1,72 @@
+#ifndef WIDE_BVH_HPP
+#define WIDE_BVH_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "BVH.hpp"
+#include "Core/SIMD.h"
+#include "Core/TraversalStack.h"
+
+namespace Spatium
+{
+	// A 4 or 8 wide copy of a binary BVH. Each node keeps its children's bounds as structure of arrays so a single SSE (4 wide) or AVX (8 wide)
+	// comparison tests all children at once, and the tree is roughly half (4 wide) or a third (8 wide) as deep as the binary one.
+	template <typename T, uint32_t Width = 4, typename Traits = BVHDefaultTraits<T>>
+	class WideBVH
+	{
+		static_assert(Width == 4 || Width == 8, "Wide BVHs are either 4 or 8 wide.");
+
+	public:
+		struct alignas(32) WideBVHNode
+		{
+		public:
+			bool IsLeaf(uint32_t childIndex) const { return m_ChildCounts[childIndex] > 0; }
+
+		public:
+			// Unused child slots hold inverted bounds so they never overlap anything.
+			float m_MinimumX[Width];
+			float m_MinimumY[Width];
+			float m_MinimumZ[Width];
+			float m_MaximumX[Width];
+			float m_MaximumY[Width];
+			float m_MaximumZ[Width];
+
+			uint32_t m_ChildOffsets[Width]; // Child node index for internal children, first index into the objects for leaf children.
+			uint32_t m_ChildCounts[Width]; // Object count for leaf children, 0 for internal children.
+		};
+
+	public:
+		void Build(const BVH<T, Traits>& sourceBVH); // Collapses the given tree. The source tree can be freely modified or destroyed afterwards.
+
+		template <typename Function>
+		void Query(const AABB& queryAABB, Function queryFunction) const; // Applies the function to all objects whose bounding box overlaps the given one.
+
+		// Same intersection callbacks as BVH<T>::IntersectClosest and BVH<T>::IntersectAny.
+		template <typename Function>
+		T IntersectClosest(const Ray& ray, float& hitDistance, Function intersectionFunction) const;
+
+		template <typename Function>
+		bool IntersectAny(const Ray& ray, float maximumDistance, Function intersectionFunction) const;
+
+		void Clear();
+
+		bool IsEmpty() const { return m_Nodes.empty(); }
+		const std::vector<WideBVHNode>& GetNodes() const { return m_Nodes; }
+		const std::vector<T>& GetObjects() const { return m_Objects; } // In leaf order.
+
+	private:
+		uint32_t GatherChildren(const typename BVH<T, Traits>::BVHNode* sourceNode, const typename BVH<T, Traits>::BVHNode** childNodes) const;
+		uint32_t ComputeOverlapMask(const WideBVHNode& wideNode, const AABB& queryAABB) const; // Bit i is set when child i overlaps the box.
+		uint32_t ComputeRayMask(const WideBVHNode& wideNode, const Ray& ray, float maximumDistance, float* entryDistances) const; // Bit i is set when the ray hits child i.
+
+	private:
+		std::vector<WideBVHNode> m_Nodes;
+		std::vector<T> m_Objects;
+		Traits m_Traits; // Copied from the source tree.
+	};
+}
+
+#include "WideBVH.inl"
+
+#endif
@@ -0,0 +1,409 @@
+#include "WideBVH.hpp"
+
+namespace Spatium
+{
+    template <typename T, uint32_t Width, typename Traits>
+    void WideBVH<T, Width, Traits>::Build(const BVH<T, Traits>& sourceBVH)
+    {
+        Clear();
+        m_Traits = sourceBVH.GetTraits();
+
+        const typename BVH<T, Traits>::BVHNode* rootNode = sourceBVH.GetRoot();
+        if (rootNode == nullptr)
+        {
+            return;
+        }
+
+        m_Nodes.reserve(sourceBVH.GetSize() / (Width / 2) + 1);
+        m_Objects.reserve(sourceBVH.GetObjectCount());
+
+        struct PendingNode
+        {
+            const typename BVH<T, Traits>::BVHNode* m_Node;
+            uint32_t m_WideIndex;
+        };
+
+        TraversalStack<PendingNode> pendingNodes;
+        m_Nodes.emplace_back();
+        pendingNodes.Push({ rootNode, 0 });
+
+        while (!pendingNodes.IsEmpty())
+        {
+            PendingNode pendingNode = pendingNodes.Pop();
+
+            const typename BVH<T, Traits>::BVHNode* childNodes[Width];
+            const uint32_t childCount = GatherChildren(pendingNode.m_Node, childNodes);
+
+            WideBVHNode wideNode;
+            for (uint32_t childIndex = 0; childIndex < Width; childIndex++)
+            {
+                wideNode.m_MinimumX[childIndex] = wideNode.m_MinimumY[childIndex] = wideNode.m_MinimumZ[childIndex] = std::numeric_limits<float>::max();
+                wideNode.m_MaximumX[childIndex] = wideNode.m_MaximumY[childIndex] = wideNode.m_MaximumZ[childIndex] = std::numeric_limits<float>::lowest();
+                wideNode.m_ChildOffsets[childIndex] = 0;
+                wideNode.m_ChildCounts[childIndex] = 0;
+            }
+
+            for (uint32_t childIndex = 0; childIndex < childCount; childIndex++)
+            {
+                const typename BVH<T, Traits>::BVHNode* childNode = childNodes[childIndex];
+
+                if (childNode->IsLeaf())
+                {
+                    wideNode.m_ChildOffsets[childIndex] = (uint32_t)m_Objects.size();
+
+                    const auto leafObjects = sourceBVH.GetObjects().begin() + childNode->m_FirstObject;
+                    m_Objects.insert(m_Objects.end(), leafObjects, leafObjects + childNode->m_ObjectCount);
+
+                    wideNode.m_ChildCounts[childIndex] = (uint32_t)m_Objects.size() - wideNode.m_ChildOffsets[childIndex];
+
+                    // Empty leafs keep their inverted bounds, otherwise they would be mistaken for internal children.
+                    if (wideNode.m_ChildCounts[childIndex] == 0)
+                    {
+                        continue;
+                    }
+                }
+                else
+                {
+                    wideNode.m_ChildOffsets[childIndex] = (uint32_t)m_Nodes.size();
+                    pendingNodes.Push({ childNode, (uint32_t)m_Nodes.size() });
+                    m_Nodes.emplace_back();
+                }
+
+                wideNode.m_MinimumX[childIndex] = childNode->m_AABB.m_Minimum.x;
+                wideNode.m_MinimumY[childIndex] = childNode->m_AABB.m_Minimum.y;
+                wideNode.m_MinimumZ[childIndex] = childNode->m_AABB.m_Minimum.z;
+                wideNode.m_MaximumX[childIndex] = childNode->m_AABB.m_Maximum.x;
+                wideNode.m_MaximumY[childIndex] = childNode->m_AABB.m_Maximum.y;
+                wideNode.m_MaximumZ[childIndex] = childNode->m_AABB.m_Maximum.z;
+            }
+
+            m_Nodes[pendingNode.m_WideIndex] = wideNode;
+        }
+    }
+
+    template <typename T, uint32_t Width, typename Traits>
+    uint32_t WideBVH<T, Width, Traits>::GatherChildren(const typename BVH<T, Traits>::BVHNode* sourceNode, const typename BVH<T, Traits>::BVHNode** childNodes) const
+    {
+        // A lone leaf root simply becomes the only child of the wide root.
+        if (sourceNode->IsLeaf())
+        {
+            childNodes[0] = sourceNode;
+            return 1;
+        }
+
+        childNodes[0] = sourceNode->m_Children[0];
+        childNodes[1] = sourceNode->m_Children[1];
+        uint32_t childCount = 2;
+
+        // Greedily pull grandchildren up into this node. Under SAH a node costs in proportion to its surface area, so opening the largest internal
+        // child first removes the most expected traversal cost. Opening it replaces its box test with those of its two children, which now run
+        // alongside their new siblings for free.
+        while (childCount < Width)
+        {
+            int largestChild = -1;
+            float largestArea = -1.0f;
+
+            for (uint32_t childIndex = 0; childIndex < childCount; childIndex++)
+            {
+                if (!childNodes[childIndex]->IsLeaf() && childNodes[childIndex]->m_AABB.GetSurfaceArea() > largestArea)
+                {
+                    largestArea = childNodes[childIndex]->m_AABB.GetSurfaceArea();
+                    largestChild = (int)childIndex;
+                }
+            }
+
+            if (largestChild == -1)
+            {
+                break;
+            }
+
+            const typename BVH<T, Traits>::BVHNode* openedNode = childNodes[largestChild];
+            childNodes[largestChild] = openedNode->m_Children[0];
+            childNodes[childCount++] = openedNode->m_Children[1];
+        }
+
+        return childCount;
+    }
+
+    template <typename T, uint32_t Width, typename Traits>
+    uint32_t WideBVH<T, Width, Traits>::ComputeOverlapMask(const WideBVHNode& wideNode, const AABB& queryAABB) const
+    {
+#if defined(SPATIUM_SIMD_AVX)
+        if constexpr (Width == 8)
+        {
+            __m256 overlap = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(wideNode.m_MinimumX), _mm256_set1_ps(queryAABB.m_Maximum.x), _CMP_LE_OQ),
+                                           _mm256_cmp_ps(_mm256_loadu_ps(wideNode.m_MaximumX), _mm256_set1_ps(queryAABB.m_Minimum.x), _CMP_GE_OQ));
+            overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(_mm256_loadu_ps(wideNode.m_MinimumY), _mm256_set1_ps(queryAABB.m_Maximum.y), _CMP_LE_OQ));
+            overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(_mm256_loadu_ps(wideNode.m_MaximumY), _mm256_set1_ps(queryAABB.m_Minimum.y), _CMP_GE_OQ));
+            overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(_mm256_loadu_ps(wideNode.m_MinimumZ), _mm256_set1_ps(queryAABB.m_Maximum.z), _CMP_LE_OQ));
+            overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(_mm256_loadu_ps(wideNode.m_MaximumZ), _mm256_set1_ps(queryAABB.m_Minimum.z), _CMP_GE_OQ));
+
+            return (uint32_t)_mm256_movemask_ps(overlap);
+        }
+        else
+#endif
+        {
+            uint32_t overlapMask = 0;
+
+#if defined(SPATIUM_SIMD_SSE)
+            // Without AVX, 8 wide nodes are tested as two halves.
+            for (uint32_t childIndex = 0; childIndex < Width; childIndex += 4)
+            {
+                __m128 overlap = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(wideNode.m_MinimumX + childIndex), _mm_set1_ps(queryAABB.m_Maximum.x)),
+                                            _mm_cmpge_ps(_mm_loadu_ps(wideNode.m_MaximumX + childIndex), _mm_set1_ps(queryAABB.m_Minimum.x)));
+                overlap = _mm_and_ps(overlap, _mm_cmple_ps(_mm_loadu_ps(wideNode.m_MinimumY + childIndex), _mm_set1_ps(queryAABB.m_Maximum.y)));
+                overlap = _mm_and_ps(overlap, _mm_cmpge_ps(_mm_loadu_ps(wideNode.m_MaximumY + childIndex), _mm_set1_ps(queryAABB.m_Minimum.y)));
+                overlap = _mm_and_ps(overlap, _mm_cmple_ps(_mm_loadu_ps(wideNode.m_MinimumZ + childIndex), _mm_set1_ps(queryAABB.m_Maximum.z)));
+                overlap = _mm_and_ps(overlap, _mm_cmpge_ps(_mm_loadu_ps(wideNode.m_MaximumZ + childIndex), _mm_set1_ps(queryAABB.m_Minimum.z)));
+
+                overlapMask |= (uint32_t)_mm_movemask_ps(overlap) << childIndex;
+            }
+#else
+            for (uint32_t childIndex = 0; childIndex < Width; childIndex++)
+            {
+                const bool overlaps = wideNode.m_MinimumX[childIndex] <= queryAABB.m_Maximum.x && wideNode.m_MaximumX[childIndex] >= queryAABB.m_Minimum.x &&
+                                      wideNode.m_MinimumY[childIndex] <= queryAABB.m_Maximum.y && wideNode.m_MaximumY[childIndex] >= queryAABB.m_Minimum.y &&
+                                      wideNode.m_MinimumZ[childIndex] <= queryAABB.m_Maximum.z && wideNode.m_MaximumZ[childIndex] >= queryAABB.m_Minimum.z;
+
+                overlapMask |= (uint32_t)overlaps << childIndex;
+            }
+#endif
+
+            return overlapMask;
+        }
+    }
+
+    template <typename T, uint32_t Width, typename Traits>
+    uint32_t WideBVH<T, Width, Traits>::ComputeRayMask(const WideBVHNode& wideNode, const Ray& ray, float maximumDistance, float* entryDistances) const
+    {
+        // Slab test on all children at once. Picking each axis' near and far plane from the ray's direction up front, rather than sorting the two
+        // distances per child, also makes the inverted bounds of unused slots miss, as their near plane lies beyond their far plane.
+        const float* nearX = ray.m_InverseDirection.x >= 0.0f ? wideNode.m_MinimumX : wideNode.m_MaximumX;
+        const float* farX = ray.m_InverseDirection.x >= 0.0f ? wideNode.m_MaximumX : wideNode.m_MinimumX;
+        const float* nearY = ray.m_InverseDirection.y >= 0.0f ? wideNode.m_MinimumY : wideNode.m_MaximumY;
+        const float* farY = ray.m_InverseDirection.y >= 0.0f ? wideNode.m_MaximumY : wideNode.m_MinimumY;
+        const float* nearZ = ray.m_InverseDirection.z >= 0.0f ? wideNode.m_MinimumZ : wideNode.m_MaximumZ;
+        const float* farZ = ray.m_InverseDirection.z >= 0.0f ? wideNode.m_MaximumZ : wideNode.m_MinimumZ;
+
+#if defined(SPATIUM_SIMD_AVX)
+        if constexpr (Width == 8)
+        {
+            const __m256 originX = _mm256_set1_ps(ray.m_Origin.x), originY = _mm256_set1_ps(ray.m_Origin.y), originZ = _mm256_set1_ps(ray.m_Origin.z);
+            const __m256 inverseX = _mm256_set1_ps(ray.m_InverseDirection.x), inverseY = _mm256_set1_ps(ray.m_InverseDirection.y), inverseZ = _mm256_set1_ps(ray.m_InverseDirection.z);
+
+            __m256 entry = _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(nearX), originX), inverseX), _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(nearY), originY), inverseY));
+            entry = _mm256_max_ps(entry, _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(nearZ), originZ), inverseZ), _mm256_setzero_ps()));
+            __m256 exit = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(farX), originX), inverseX), _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(farY), originY), inverseY));
+            exit = _mm256_min_ps(exit, _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(farZ), originZ), inverseZ), _mm256_set1_ps(maximumDistance)));
+
+            _mm256_storeu_ps(entryDistances, entry);
+            return (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(entry, exit, _CMP_LE_OQ));
+        }
+        else
+#endif
+        {
+            uint32_t hitMask = 0;
+
+#if defined(SPATIUM_SIMD_SSE)
+            const __m128 originX = _mm_set1_ps(ray.m_Origin.x), originY = _mm_set1_ps(ray.m_Origin.y), originZ = _mm_set1_ps(ray.m_Origin.z);
+            const __m128 inverseX = _mm_set1_ps(ray.m_InverseDirection.x), inverseY = _mm_set1_ps(ray.m_InverseDirection.y), inverseZ = _mm_set1_ps(ray.m_InverseDirection.z);
+
+            for (uint32_t childIndex = 0; childIndex < Width; childIndex += 4)
+            {
+                __m128 entry = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(nearX + childIndex), originX), inverseX), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(nearY + childIndex), originY), inverseY));
+                entry = _mm_max_ps(entry, _mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(nearZ + childIndex), originZ), inverseZ), _mm_setzero_ps()));
+                __m128 exit = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(farX + childIndex), originX), inverseX), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(farY + childIndex), originY), inverseY));
+                exit = _mm_min_ps(exit, _mm_min_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(farZ + childIndex), originZ), inverseZ), _mm_set1_ps(maximumDistance)));
+
+                _mm_storeu_ps(entryDistances + childIndex, entry);
+                hitMask |= (uint32_t)_mm_movemask_ps(_mm_cmple_ps(entry, exit)) << childIndex;
+            }
+#else
+            for (uint32_t childIndex = 0; childIndex < Width; childIndex++)
+            {
+                const float entry = std::max(std::max((nearX[childIndex] - ray.m_Origin.x) * ray.m_InverseDirection.x, (nearY[childIndex] - ray.m_Origin.y) * ray.m_InverseDirection.y),
+                                             std::max((nearZ[childIndex] - ray.m_Origin.z) * ray.m_InverseDirection.z, 0.0f));
+                const float exit = std::min(std::min((farX[childIndex] - ray.m_Origin.x) * ray.m_InverseDirection.x, (farY[childIndex] - ray.m_Origin.y) * ray.m_InverseDirection.y),
+                                            std::min((farZ[childIndex] - ray.m_Origin.z) * ray.m_InverseDirection.z, maximumDistance));
+
+                entryDistances[childIndex] = entry;
+                hitMask |= (uint32_t)(entry <= exit) << childIndex;
+            }
+#endif
+
+            return hitMask;
+        }
+    }
+
+    template <typename T, uint32_t Width, typename Traits>
+    template <typename Function>
+    T WideBVH<T, Width, Traits>::IntersectClosest(const Ray& ray, float& hitDistance, Function intersectionFunction) const
+    {
+        T closestObject = m_Traits.GetNullObject();
+        if (m_Nodes.empty())
+        {
+            return closestObject;
+        }
+
+        struct PendingChild
+        {
+            uint32_t m_NodeIndex;
+            float m_EntryDistance;
+        };
+
+        TraversalStack<PendingChild> nodeStack;
+        nodeStack.Push({ 0, 0.0f });
+
+        while (!nodeStack.IsEmpty())
+        {
+            PendingChild pendingChild = nodeStack.Pop();
+            if (pendingChild.m_EntryDistance > hitDistance)
+            {
+                continue;
+            }
+
+            const WideBVHNode& currentNode = m_Nodes[pendingChild.m_NodeIndex];
+            float entryDistances[Width];
+            const uint32_t hitMask = ComputeRayMask(currentNode, ray, hitDistance, entryDistances);
+
+            // Leaf children are tested right away. Internal children are pushed farthest first so the nearest is visited next.
+            PendingChild hitChildren[Width];
+            uint32_t hitChildCount = 0;
+
+            for (uint32_t childIndex = 0; childIndex < Width; childIndex++)
+            {
+                if ((hitMask & (1u << childIndex)) == 0)
+                {
+                    continue;
+                }
+
+                if (currentNode.IsLeaf(childIndex))
+                {
+                    const uint32_t endIndex = currentNode.m_ChildOffsets[childIndex] + currentNode.m_ChildCounts[childIndex];
+                    for (uint32_t objectIndex = currentNode.m_ChildOffsets[childIndex]; objectIndex < endIndex; objectIndex++)
+                    {
+                        float objectDistance;
+                        if (m_Traits.GetAABB(m_Objects[objectIndex]).IntersectRay(ray, hitDistance, objectDistance) && intersectionFunction(m_Objects[objectIndex], hitDistance))
+                        {
+                            closestObject = m_Objects[objectIndex];
+                        }
+                    }
+
+                    continue;
+                }
+
+                uint32_t insertIndex = hitChildCount++;
+                while (insertIndex > 0 && hitChildren[insertIndex - 1].m_EntryDistance < entryDistances[childIndex])
+                {
+                    hitChildren[insertIndex] = hitChildren[insertIndex - 1];
+                    insertIndex--;
+                }
+
+                hitChildren[insertIndex] = { currentNode.m_ChildOffsets[childIndex], entryDistances[childIndex] };
+            }
+
+            for (uint32_t hitIndex = 0; hitIndex < hitChildCount; hitIndex++)
+            {
+                nodeStack.Push(hitChildren[hitIndex]);
+            }
+        }
+
+        return closestObject;
+    }
+
+    template <typename T, uint32_t Width, typename Traits>
+    template <typename Function>
+    bool WideBVH<T, Width, Traits>::IntersectAny(const Ray& ray, float maximumDistance, Function intersectionFunction) const
+    {
+        if (m_Nodes.empty())
+        {
+            return false;
+        }
+
+        TraversalStack<uint32_t> nodeStack;
+        nodeStack.Push(0);
+
+        while (!nodeStack.IsEmpty())
+        {
+            const WideBVHNode& currentNode = m_Nodes[nodeStack.Pop()];
+            float entryDistances[Width];
+            const uint32_t hitMask = ComputeRayMask(currentNode, ray, maximumDistance, entryDistances);
+
+            for (uint32_t childIndex = 0; childIndex < Width; childIndex++)
+            {
+                if ((hitMask & (1u << childIndex)) == 0)
+                {
+                    continue;
+                }
+
+                if (!currentNode.IsLeaf(childIndex))
+                {
+                    nodeStack.Push(currentNode.m_ChildOffsets[childIndex]);
+                    continue;
+                }
+
+                const uint32_t endIndex = currentNode.m_ChildOffsets[childIndex] + currentNode.m_ChildCounts[childIndex];
+                for (uint32_t objectIndex = currentNode.m_ChildOffsets[childIndex]; objectIndex < endIndex; objectIndex++)
+                {
+                    float objectDistance = maximumDistance;
+                    if (m_Traits.GetAABB(m_Objects[objectIndex]).IntersectRay(ray, maximumDistance, entryDistances[childIndex]) && intersectionFunction(m_Objects[objectIndex], objectDistance))
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    template <typename T, uint32_t Width, typename Traits>
+    template <typename Function>
+    void WideBVH<T, Width, Traits>::Query(const AABB& queryAABB, Function queryFunction) const
+    {
+        if (m_Nodes.empty())
+        {
+            return;
+        }
+
+        TraversalStack<uint32_t> nodeStack;
+        nodeStack.Push(0);
+
+        while (!nodeStack.IsEmpty())
+        {
+            const WideBVHNode& currentNode = m_Nodes[nodeStack.Pop()];
+            const uint32_t overlapMask = ComputeOverlapMask(currentNode, queryAABB);
+
+            for (uint32_t childIndex = 0; childIndex < Width; childIndex++)
+            {
+                if ((overlapMask & (1u << childIndex)) == 0)
+                {
+                    continue;
+                }
+
+                if (currentNode.IsLeaf(childIndex))
+                {
+                    const uint32_t endIndex = currentNode.m_ChildOffsets[childIndex] + currentNode.m_ChildCounts[childIndex];
+                    for (uint32_t objectIndex = currentNode.m_ChildOffsets[childIndex]; objectIndex < endIndex; objectIndex++)
+                    {
+                        if (m_Traits.GetAABB(m_Objects[objectIndex]).Overlaps(queryAABB))
+                        {
+                            queryFunction(m_Objects[objectIndex]);
+                        }
+                    }
+                }
+                else
+                {
+                    nodeStack.Push(currentNode.m_ChildOffsets[childIndex]);
+                }
+            }
+        }
+    }
+
+    template <typename T, uint32_t Width, typename Traits>
+    void WideBVH<T, Width, Traits>::Clear()
+    {
+        m_Nodes.clear();
+        m_Objects.clear();
+    }
+}
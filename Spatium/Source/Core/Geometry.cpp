@@ -1,8 +1,15 @@
 #include "Geometry.h"
 #include <stdexcept>
+#include <cmath>
+#include <limits>
 
 namespace Spatium
 {
+	Ray::Ray(const glm::vec3& origin, const glm::vec3& direction) : m_Origin(origin), m_Direction(direction), m_InverseDirection(1.0f / direction)
+	{
+
+	}
+
 	void AABB::Expand(const AABB& other)
 	{
 		m_Minimum = glm::min(m_Minimum, other.m_Minimum);
@@ -17,6 +24,62 @@ namespace Spatium
 		return result;
 	}
 
+	bool AABB::Overlaps(const AABB& other) const
+	{
+		return m_Minimum.x <= other.m_Maximum.x && m_Maximum.x >= other.m_Minimum.x &&
+			   m_Minimum.y <= other.m_Maximum.y && m_Maximum.y >= other.m_Minimum.y &&
+			   m_Minimum.z <= other.m_Maximum.z && m_Maximum.z >= other.m_Minimum.z;
+	}
+
+	bool AABB::Contains(const AABB& other) const
+	{
+		return m_Minimum.x <= other.m_Minimum.x && m_Maximum.x >= other.m_Maximum.x &&
+			   m_Minimum.y <= other.m_Minimum.y && m_Maximum.y >= other.m_Maximum.y &&
+			   m_Minimum.z <= other.m_Minimum.z && m_Maximum.z >= other.m_Maximum.z;
+	}
+
+	bool AABB::IntersectRay(const Ray& ray, float maximumDistance, float& entryDistance) const
+	{
+		// Slab test. Min/max picks the near and far plane on each axis regardless of the ray's direction, so there are no branches.
+		const glm::vec3 planeDistancesA = (m_Minimum - ray.m_Origin) * ray.m_InverseDirection;
+		const glm::vec3 planeDistancesB = (m_Maximum - ray.m_Origin) * ray.m_InverseDirection;
+		const glm::vec3 nearDistances = glm::min(planeDistancesA, planeDistancesB);
+		const glm::vec3 farDistances = glm::max(planeDistancesA, planeDistancesB);
+
+		entryDistance = glm::max(glm::max(nearDistances.x, nearDistances.y), glm::max(nearDistances.z, 0.0f));
+		const float exitDistance = glm::min(glm::min(farDistances.x, farDistances.y), glm::min(farDistances.z, maximumDistance));
+
+		return entryDistance <= exitDistance;
+	}
+
+	float AABB::GetSquaredDistance(const glm::vec3& point) const
+	{
+		const glm::vec3 offset = glm::max(glm::max(m_Minimum - point, point - m_Maximum), glm::vec3(0.0f));
+		return glm::dot(offset, offset);
+	}
+
+	AABB AABB::Transform(const glm::mat4& transform) const
+	{
+		// Arvo's method. Each matrix entry scales one axis of the box into another, and the smaller and larger of its products with the box's extents
+		// go to the new minimum and maximum respectively.
+		const glm::vec3 translation(transform[3]);
+		AABB result(translation, translation);
+
+		for (int column = 0; column < 3; column++)
+		{
+			for (int row = 0; row < 3; row++)
+			{
+				const float minimumProduct = transform[column][row] * m_Minimum[column];
+				const float maximumProduct = transform[column][row] * m_Maximum[column];
+
+				result.m_Minimum[row] += glm::min(minimumProduct, maximumProduct);
+				result.m_Maximum[row] += glm::max(minimumProduct, maximumProduct);
+			}
+		}
+
+		return result;
+	}
+
 	float AABB::GetVolume() const
 	{
 		glm::vec3 dimensions = m_Maximum - m_Minimum;
@@ -34,6 +97,58 @@ namespace Spatium
 		return (m_Minimum + m_Maximum) * 0.5f;
 	}
 
+	Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+	{
+		// Each plane is the sum or difference of the matrix's last row with one of the others (Gribb & Hartmann). GLM matrices are column major.
+		const glm::vec4 rowX(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+		const glm::vec4 rowY(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+		const glm::vec4 rowZ(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+		const glm::vec4 rowW(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+		Frustum frustum;
+		frustum.m_Planes[0] = rowW + rowX;
+		frustum.m_Planes[1] = rowW - rowX;
+		frustum.m_Planes[2] = rowW + rowY;
+		frustum.m_Planes[3] = rowW - rowY;
+		frustum.m_Planes[4] = rowW + rowZ;
+		frustum.m_Planes[5] = rowW - rowZ;
+
+		for (glm::vec4& plane : frustum.m_Planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+
+		return frustum;
+	}
+
+	FrustumClassification Frustum::ClassifyAABB(const AABB& aabb, uint32_t& planeMask) const
+	{
+		for (uint32_t planeIndex = 0; planeIndex < 6; planeIndex++)
+		{
+			if ((planeMask & (1u << planeIndex)) == 0)
+			{
+				continue;
+			}
+
+			// The corners furthest along (p-vertex) and against (n-vertex) the plane's normal decide whether the box is outside or fully inside.
+			const glm::vec3 planeNormal(m_Planes[planeIndex]);
+			const glm::vec3 positiveVertex(planeNormal.x >= 0.0f ? aabb.m_Maximum.x : aabb.m_Minimum.x, planeNormal.y >= 0.0f ? aabb.m_Maximum.y : aabb.m_Minimum.y, planeNormal.z >= 0.0f ? aabb.m_Maximum.z : aabb.m_Minimum.z);
+			const glm::vec3 negativeVertex(planeNormal.x >= 0.0f ? aabb.m_Minimum.x : aabb.m_Maximum.x, planeNormal.y >= 0.0f ? aabb.m_Minimum.y : aabb.m_Maximum.y, planeNormal.z >= 0.0f ? aabb.m_Minimum.z : aabb.m_Maximum.z);
+
+			if (glm::dot(planeNormal, positiveVertex) + m_Planes[planeIndex].w < 0.0f)
+			{
+				return FrustumClassification::Outside;
+			}
+
+			if (glm::dot(planeNormal, negativeVertex) + m_Planes[planeIndex].w >= 0.0f)
+			{
+				planeMask &= ~(1u << planeIndex);
+			}
+		}
+
+		return planeMask == 0 ? FrustumClassification::Inside : FrustumClassification::Intersecting;
+	}
+
 	Triangle::Triangle(const glm::vec3& pointA, const glm::vec3& pointB, const glm::vec3& pointC)
 	{
 		m_Points[0] = pointA;
@@ -76,4 +191,43 @@ namespace Spatium
 	{
 		return glm::max(glm::max(m_Points[0], m_Points[1]), m_Points[2]);
 	}
+
+	bool Triangle::IntersectRay(const Ray& ray, float maximumDistance, float& hitDistance) const
+	{
+		// Moller-Trumbore. Solves for the hit's barycentric coordinates and distance along the ray in one go, using Cramer's rule.
+		const glm::vec3 edgeA = m_Points[1] - m_Points[0];
+		const glm::vec3 edgeB = m_Points[2] - m_Points[0];
+		const glm::vec3 directionCrossEdgeB = glm::cross(ray.m_Direction, edgeB);
+		const float determinant = glm::dot(edgeA, directionCrossEdgeB);
+
+		// The ray runs parallel to the triangle.
+		if (std::abs(determinant) < std::numeric_limits<float>::epsilon())
+		{
+			return false;
+		}
+
+		const float inverseDeterminant = 1.0f / determinant;
+		const glm::vec3 originOffset = ray.m_Origin - m_Points[0];
+		const float u = glm::dot(originOffset, directionCrossEdgeB) * inverseDeterminant;
+		if (u < 0.0f || u > 1.0f)
+		{
+			return false;
+		}
+
+		const glm::vec3 offsetCrossEdgeA = glm::cross(originOffset, edgeA);
+		const float v = glm::dot(ray.m_Direction, offsetCrossEdgeA) * inverseDeterminant;
+		if (v < 0.0f || u + v > 1.0f)
+		{
+			return false;
+		}
+
+		const float distance = glm::dot(edgeB, offsetCrossEdgeA) * inverseDeterminant;
+		if (distance < 0.0f || distance >= maximumDistance)
+		{
+			return false;
+		}
+
+		hitDistance = distance;
+		return true;
+	}
 }
\ No newline at end of file
@@ -3,6 +3,18 @@
 
 namespace Spatium
 {
+	struct Ray
+	{
+	public:
+		Ray() = default;
+		Ray(const glm::vec3& origin, const glm::vec3& direction);
+
+	public:
+		glm::vec3 m_Origin = { 0.0f, 0.0f, 0.0f };
+		glm::vec3 m_Direction = { 0.0f, 0.0f, 1.0f };
+		glm::vec3 m_InverseDirection = { 0.0f, 0.0f, 0.0f }; // Precomputed for slab tests. Zero direction components become infinities.
+	};
+
 	struct AABB
 	{
 	public:
@@ -11,6 +23,11 @@ namespace Spatium
 
 		void Expand(const AABB& other);
 		AABB Union(const AABB& other) const;
+		bool Overlaps(const AABB& other) const;
+		bool Contains(const AABB& other) const;
+		bool IntersectRay(const Ray& ray, float maximumDistance, float& entryDistance) const; // Hits between the ray's origin and maximumDistance only.
+		float GetSquaredDistance(const glm::vec3& point) const; // 0 for points inside the box.
+		AABB Transform(const glm::mat4& transform) const; // The box around the transformed box, which is larger than it for rotations.
 
 		float GetVolume() const;
 		float GetSurfaceArea() const;
@@ -21,6 +38,28 @@ namespace Spatium
 		glm::vec3 m_Maximum = { 0.0f, 0.0f, 0.0f };
 	};
 
+	enum class FrustumClassification
+	{
+		Outside,
+		Intersecting,
+		Inside
+	};
+
+	struct Frustum
+	{
+	public:
+		Frustum() = default;
+
+		static Frustum FromMatrix(const glm::mat4& viewProjection); // Extracts the planes of a GLM (OpenGL clip space) view projection matrix.
+
+		// Only the planes set in planeMask are tested. Planes the box lies fully inside of are cleared from the mask, which makes it reusable for
+		// anything contained in the box, such as a node's children.
+		FrustumClassification ClassifyAABB(const AABB& aabb, uint32_t& planeMask) const;
+
+	public:
+		glm::vec4 m_Planes[6] = { }; // Left, right, bottom, top, near, far. Normals point inwards, so p is inside when dot(normal, p) + w >= 0.
+	};
+
 	struct Triangle
 	{
 	public:
@@ -33,6 +72,8 @@ namespace Spatium
 		glm::vec3 GetMinimumPoint() const;
 		glm::vec3 GetMaximumPoint() const;
 
+		bool IntersectRay(const Ray& ray, float maximumDistance, float& hitDistance) const; // Two sided. Only hits closer than maximumDistance count.
+
 	public:
 		glm::vec3 m_Points[3] = { };
 	};
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Spatium
+{
+	// Spreads the lower 21 bits of a value out so that two zero bits sit between each of them.
+	inline uint64_t ExpandBitsBy3(uint32_t value)
+	{
+		uint64_t x = value & 0x1fffff;
+		x = (x | x << 32) & 0x1f00000000ffff;
+		x = (x | x << 16) & 0x1f0000ff0000ff;
+		x = (x | x << 8) & 0x100f00f00f00f00f;
+		x = (x | x << 4) & 0x10c30c30c30c30c3;
+		x = (x | x << 2) & 0x1249249249249249;
+		return x;
+	}
+
+	// Interleaves three quantized coordinates into a Morton code. Supports up to 21 bits per axis for 63-bit codes.
+	inline uint64_t EncodeMorton3D(uint32_t x, uint32_t y, uint32_t z)
+	{
+		return (ExpandBitsBy3(x) << 2) | (ExpandBitsBy3(y) << 1) | ExpandBitsBy3(z);
+	}
+
+	inline int CountLeadingZeros(uint64_t value)
+	{
+		if (value == 0)
+		{
+			return 64;
+		}
+
+#if defined(_MSC_VER)
+		unsigned long bitIndex;
+		_BitScanReverse64(&bitIndex, value);
+		return 63 - static_cast<int>(bitIndex);
+#else
+		return __builtin_clzll(value);
+#endif
+	}
+}
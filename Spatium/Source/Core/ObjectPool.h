@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace Spatium
+{
+	// Hands out objects from a list of geometrically growing blocks that are kept around until the pool itself is destroyed. Allocation is a single
+	// atomic increment in the common case and may be called from several threads at once, while Reset() recycles every object in constant time.
+	template <typename Type>
+	class ObjectPool
+	{
+		static_assert(std::is_trivially_destructible<Type>::value, "Pooled objects are never destroyed individually on Reset().");
+
+	public:
+		ObjectPool(uint32_t firstBlockSize = 256);
+		~ObjectPool();
+
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+
+		Type* Allocate(); // Thread safe.
+		void Free(Type* object); // Thread safe. The object is handed out again by a later allocation.
+		void Reset(); // Recycles every object at once. Not thread safe, and any outstanding pointers become invalid.
+
+		size_t GetAllocatedCount() const { return m_NextIndex.load(std::memory_order_relaxed) - m_FreeCount.load(std::memory_order_relaxed); }
+
+	private:
+		static uint32_t FindBlock(uint64_t blockUnits); // Returns floor(log2(blockUnits)).
+		Type* GetBlock(uint32_t blockIndex);
+
+	private:
+		static constexpr uint32_t s_MaximumBlocks = 48; // Block i holds firstBlockSize * 2^i objects, which is far beyond any realistic pool.
+
+		const uint32_t m_FirstBlockSize;
+		std::atomic<Type*> m_Blocks[s_MaximumBlocks];
+		std::atomic<uint64_t> m_NextIndex = { 0 };
+		std::mutex m_BlockMutex;
+
+		std::vector<Type*> m_FreeObjects;
+		std::atomic<size_t> m_FreeCount = { 0 }; // Lets allocations skip the free list lock entirely while it is empty, such as during builds.
+		std::mutex m_FreeMutex;
+	};
+
+	template <typename Type>
+	ObjectPool<Type>::ObjectPool(uint32_t firstBlockSize) : m_FirstBlockSize(firstBlockSize > 0 ? firstBlockSize : 1)
+	{
+		for (std::atomic<Type*>& block : m_Blocks)
+		{
+			block.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	template <typename Type>
+	ObjectPool<Type>::~ObjectPool()
+	{
+		std::allocator<Type> blockAllocator;
+
+		for (uint32_t blockIndex = 0; blockIndex < s_MaximumBlocks; blockIndex++)
+		{
+			if (Type* block = m_Blocks[blockIndex].load(std::memory_order_relaxed))
+			{
+				blockAllocator.deallocate(block, (size_t)m_FirstBlockSize << blockIndex);
+			}
+		}
+	}
+
+	template <typename Type>
+	Type* ObjectPool<Type>::Allocate()
+	{
+		if (m_FreeCount.load(std::memory_order_acquire) > 0)
+		{
+			std::lock_guard<std::mutex> freeLock(m_FreeMutex);
+			if (!m_FreeObjects.empty())
+			{
+				Type* object = m_FreeObjects.back();
+				m_FreeObjects.pop_back();
+				m_FreeCount.store(m_FreeObjects.size(), std::memory_order_release);
+
+				return new (object) Type();
+			}
+		}
+
+		// Block i starts at firstBlockSize * (2^i - 1), so an index maps to its block through its highest set bit.
+		const uint64_t objectIndex = m_NextIndex.fetch_add(1, std::memory_order_relaxed);
+		const uint32_t blockIndex = FindBlock(objectIndex / m_FirstBlockSize + 1);
+		const uint64_t blockStart = (uint64_t)m_FirstBlockSize * ((1ull << blockIndex) - 1);
+
+		return new (GetBlock(blockIndex) + (objectIndex - blockStart)) Type();
+	}
+
+	template <typename Type>
+	void ObjectPool<Type>::Free(Type* object)
+	{
+		std::lock_guard<std::mutex> freeLock(m_FreeMutex);
+		m_FreeObjects.push_back(object);
+		m_FreeCount.store(m_FreeObjects.size(), std::memory_order_release);
+	}
+
+	template <typename Type>
+	void ObjectPool<Type>::Reset()
+	{
+		m_NextIndex.store(0, std::memory_order_relaxed);
+		m_FreeObjects.clear();
+		m_FreeCount.store(0, std::memory_order_relaxed);
+	}
+
+	template <typename Type>
+	uint32_t ObjectPool<Type>::FindBlock(uint64_t blockUnits)
+	{
+		uint32_t blockIndex = 0;
+		while (blockUnits >>= 1)
+		{
+			blockIndex++;
+		}
+
+		return blockIndex;
+	}
+
+	template <typename Type>
+	Type* ObjectPool<Type>::GetBlock(uint32_t blockIndex)
+	{
+		Type* block = m_Blocks[blockIndex].load(std::memory_order_acquire);
+		if (block != nullptr)
+		{
+			return block;
+		}
+
+		// Only the first thread to reach a new block allocates it. The rest wait here briefly and pick it up.
+		std::lock_guard<std::mutex> blockLock(m_BlockMutex);
+		block = m_Blocks[blockIndex].load(std::memory_order_relaxed);
+		if (block == nullptr)
+		{
+			block = std::allocator<Type>().allocate((size_t)m_FirstBlockSize << blockIndex);
+			m_Blocks[blockIndex].store(block, std::memory_order_release);
+		}
+
+		return block;
+	}
+}
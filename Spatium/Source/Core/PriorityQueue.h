@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+namespace Spatium
+{
+	// A binary heap that, like TraversalStack, lives on the call stack until it outgrows its inline capacity. As with std::priority_queue, the top
+	// is the largest value under Compare, so std::greater gives a min-queue.
+	template <typename Type, typename Compare = std::less<Type>, size_t InlineCapacity = 64>
+	class PriorityQueue
+	{
+	public:
+		void Push(const Type& value)
+		{
+			if (m_Size == InlineCapacity && m_OverflowValues.empty())
+			{
+				m_OverflowValues.assign(m_InlineValues, m_InlineValues + m_Size);
+			}
+
+			if (m_OverflowValues.empty())
+			{
+				m_InlineValues[m_Size] = value;
+			}
+			else
+			{
+				m_OverflowValues.push_back(value);
+			}
+
+			m_Size++;
+			std::push_heap(GetValues(), GetValues() + m_Size, Compare());
+		}
+
+		Type Pop()
+		{
+			std::pop_heap(GetValues(), GetValues() + m_Size, Compare());
+			m_Size--;
+
+			Type value = GetValues()[m_Size];
+			if (!m_OverflowValues.empty())
+			{
+				m_OverflowValues.pop_back();
+			}
+
+			return value;
+		}
+
+		const Type& GetTop() const { return GetValues()[0]; }
+		const Type* GetValues() const { return m_OverflowValues.empty() ? m_InlineValues : m_OverflowValues.data(); } // In heap order.
+		bool IsEmpty() const { return m_Size == 0; }
+		size_t GetSize() const { return m_Size; }
+
+	private:
+		Type* GetValues() { return m_OverflowValues.empty() ? m_InlineValues : m_OverflowValues.data(); }
+
+	private:
+		Type m_InlineValues[InlineCapacity];
+		std::vector<Type> m_OverflowValues; // Takes over from the inline values for good once they run out.
+		size_t m_Size = 0;
+	};
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+
+#include "Geometry.h"
+#include "SIMD.h"
+
+namespace Spatium
+{
+	// A group of 4, 8 or 16 rays stored as structure of arrays, so that a single box can be tested against several rays with each SIMD instruction.
+	template <uint32_t Size>
+	struct alignas(64) RayPacket
+	{
+		static_assert(Size == 4 || Size == 8 || Size == 16, "Ray packets hold 4, 8 or 16 rays.");
+
+	public:
+		void SetRay(uint32_t rayIndex, const Ray& ray);
+		Ray GetRay(uint32_t rayIndex) const;
+
+		uint32_t IntersectAABB(const AABB& aabb, const float* maximumDistances, uint32_t activeMask) const; // Bit i is set when active ray i hits the box within maximumDistances[i].
+
+	public:
+		float m_OriginX[Size], m_OriginY[Size], m_OriginZ[Size];
+		float m_DirectionX[Size], m_DirectionY[Size], m_DirectionZ[Size];
+		float m_InverseDirectionX[Size], m_InverseDirectionY[Size], m_InverseDirectionZ[Size];
+	};
+
+	template <uint32_t Size>
+	void RayPacket<Size>::SetRay(uint32_t rayIndex, const Ray& ray)
+	{
+		m_OriginX[rayIndex] = ray.m_Origin.x;
+		m_OriginY[rayIndex] = ray.m_Origin.y;
+		m_OriginZ[rayIndex] = ray.m_Origin.z;
+		m_DirectionX[rayIndex] = ray.m_Direction.x;
+		m_DirectionY[rayIndex] = ray.m_Direction.y;
+		m_DirectionZ[rayIndex] = ray.m_Direction.z;
+		m_InverseDirectionX[rayIndex] = ray.m_InverseDirection.x;
+		m_InverseDirectionY[rayIndex] = ray.m_InverseDirection.y;
+		m_InverseDirectionZ[rayIndex] = ray.m_InverseDirection.z;
+	}
+
+	template <uint32_t Size>
+	Ray RayPacket<Size>::GetRay(uint32_t rayIndex) const
+	{
+		Ray ray;
+		ray.m_Origin = glm::vec3(m_OriginX[rayIndex], m_OriginY[rayIndex], m_OriginZ[rayIndex]);
+		ray.m_Direction = glm::vec3(m_DirectionX[rayIndex], m_DirectionY[rayIndex], m_DirectionZ[rayIndex]);
+		ray.m_InverseDirection = glm::vec3(m_InverseDirectionX[rayIndex], m_InverseDirectionY[rayIndex], m_InverseDirectionZ[rayIndex]);
+
+		return ray;
+	}
+
+	template <uint32_t Size>
+	uint32_t RayPacket<Size>::IntersectAABB(const AABB& aabb, const float* maximumDistances, uint32_t activeMask) const
+	{
+		// The same slab test as AABB::IntersectRay, one group of rays at a time. Groups without any active rays are skipped entirely.
+		uint32_t hitMask = 0;
+
+#if defined(SPATIUM_SIMD_AVX)
+		if constexpr (Size >= 8)
+		{
+			const __m256 minimumX = _mm256_set1_ps(aabb.m_Minimum.x), minimumY = _mm256_set1_ps(aabb.m_Minimum.y), minimumZ = _mm256_set1_ps(aabb.m_Minimum.z);
+			const __m256 maximumX = _mm256_set1_ps(aabb.m_Maximum.x), maximumY = _mm256_set1_ps(aabb.m_Maximum.y), maximumZ = _mm256_set1_ps(aabb.m_Maximum.z);
+
+			for (uint32_t rayIndex = 0; rayIndex < Size; rayIndex += 8)
+			{
+				if (((activeMask >> rayIndex) & 0xff) == 0)
+				{
+					continue;
+				}
+
+				const __m256 originX = _mm256_loadu_ps(m_OriginX + rayIndex), originY = _mm256_loadu_ps(m_OriginY + rayIndex), originZ = _mm256_loadu_ps(m_OriginZ + rayIndex);
+				const __m256 inverseX = _mm256_loadu_ps(m_InverseDirectionX + rayIndex), inverseY = _mm256_loadu_ps(m_InverseDirectionY + rayIndex), inverseZ = _mm256_loadu_ps(m_InverseDirectionZ + rayIndex);
+
+				const __m256 distancesAX = _mm256_mul_ps(_mm256_sub_ps(minimumX, originX), inverseX), distancesBX = _mm256_mul_ps(_mm256_sub_ps(maximumX, originX), inverseX);
+				const __m256 distancesAY = _mm256_mul_ps(_mm256_sub_ps(minimumY, originY), inverseY), distancesBY = _mm256_mul_ps(_mm256_sub_ps(maximumY, originY), inverseY);
+				const __m256 distancesAZ = _mm256_mul_ps(_mm256_sub_ps(minimumZ, originZ), inverseZ), distancesBZ = _mm256_mul_ps(_mm256_sub_ps(maximumZ, originZ), inverseZ);
+
+				__m256 entry = _mm256_max_ps(_mm256_min_ps(distancesAX, distancesBX), _mm256_min_ps(distancesAY, distancesBY));
+				entry = _mm256_max_ps(entry, _mm256_max_ps(_mm256_min_ps(distancesAZ, distancesBZ), _mm256_setzero_ps()));
+				__m256 exit = _mm256_min_ps(_mm256_max_ps(distancesAX, distancesBX), _mm256_max_ps(distancesAY, distancesBY));
+				exit = _mm256_min_ps(exit, _mm256_min_ps(_mm256_max_ps(distancesAZ, distancesBZ), _mm256_loadu_ps(maximumDistances + rayIndex)));
+
+				hitMask |= (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(entry, exit, _CMP_LE_OQ)) << rayIndex;
+			}
+		}
+		else
+#endif
+		{
+#if defined(SPATIUM_SIMD_SSE)
+			const __m128 minimumX = _mm_set1_ps(aabb.m_Minimum.x), minimumY = _mm_set1_ps(aabb.m_Minimum.y), minimumZ = _mm_set1_ps(aabb.m_Minimum.z);
+			const __m128 maximumX = _mm_set1_ps(aabb.m_Maximum.x), maximumY = _mm_set1_ps(aabb.m_Maximum.y), maximumZ = _mm_set1_ps(aabb.m_Maximum.z);
+
+			for (uint32_t rayIndex = 0; rayIndex < Size; rayIndex += 4)
+			{
+				if (((activeMask >> rayIndex) & 0xf) == 0)
+				{
+					continue;
+				}
+
+				const __m128 originX = _mm_loadu_ps(m_OriginX + rayIndex), originY = _mm_loadu_ps(m_OriginY + rayIndex), originZ = _mm_loadu_ps(m_OriginZ + rayIndex);
+				const __m128 inverseX = _mm_loadu_ps(m_InverseDirectionX + rayIndex), inverseY = _mm_loadu_ps(m_InverseDirectionY + rayIndex), inverseZ = _mm_loadu_ps(m_InverseDirectionZ + rayIndex);
+
+				const __m128 distancesAX = _mm_mul_ps(_mm_sub_ps(minimumX, originX), inverseX), distancesBX = _mm_mul_ps(_mm_sub_ps(maximumX, originX), inverseX);
+				const __m128 distancesAY = _mm_mul_ps(_mm_sub_ps(minimumY, originY), inverseY), distancesBY = _mm_mul_ps(_mm_sub_ps(maximumY, originY), inverseY);
+				const __m128 distancesAZ = _mm_mul_ps(_mm_sub_ps(minimumZ, originZ), inverseZ), distancesBZ = _mm_mul_ps(_mm_sub_ps(maximumZ, originZ), inverseZ);
+
+				__m128 entry = _mm_max_ps(_mm_min_ps(distancesAX, distancesBX), _mm_min_ps(distancesAY, distancesBY));
+				entry = _mm_max_ps(entry, _mm_max_ps(_mm_min_ps(distancesAZ, distancesBZ), _mm_setzero_ps()));
+				__m128 exit = _mm_min_ps(_mm_max_ps(distancesAX, distancesBX), _mm_max_ps(distancesAY, distancesBY));
+				exit = _mm_min_ps(exit, _mm_min_ps(_mm_max_ps(distancesAZ, distancesBZ), _mm_loadu_ps(maximumDistances + rayIndex)));
+
+				hitMask |= (uint32_t)_mm_movemask_ps(_mm_cmple_ps(entry, exit)) << rayIndex;
+			}
+#else
+			for (uint32_t rayIndex = 0; rayIndex < Size; rayIndex++)
+			{
+				float entryDistance;
+				if ((activeMask & (1u << rayIndex)) && aabb.IntersectRay(GetRay(rayIndex), maximumDistances[rayIndex], entryDistance))
+				{
+					hitMask |= 1u << rayIndex;
+				}
+			}
+#endif
+		}
+
+		return hitMask & activeMask;
+	}
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// SIMD Support. x64 always has SSE2, while AVX has to be enabled by the compiler (/arch:AVX, -mavx).
+#if defined(__AVX__)
+#define SPATIUM_SIMD_AVX
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPATIUM_SIMD_SSE
+#endif
+
+#if defined(SPATIUM_SIMD_AVX)
+#include <immintrin.h>
+#elif defined(SPATIUM_SIMD_SSE)
+#include <emmintrin.h>
+#endif
@@ -0,0 +1,91 @@
+#include "ThreadPool.h"
+
+namespace Spatium
+{
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		for (uint32_t i = 1; i < threadCount; i++)
+		{
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_IsStopping = true;
+		}
+
+		m_Condition.notify_all();
+		for (std::thread& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	void ThreadPool::Wait(std::future<void>& taskFuture)
+	{
+		auto IsReady = [&taskFuture]()
+		{
+			return taskFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		};
+
+		while (!IsReady())
+		{
+			// Help out with queued work instead of idling. The task we are waiting on may well be in the queue itself.
+			if (RunPendingTask())
+			{
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [&]() { return !m_Tasks.empty() || IsReady(); });
+		}
+
+		taskFuture.get(); // Rethrows anything the task threw.
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Condition.wait(lock, [this]() { return m_IsStopping || !m_Tasks.empty(); });
+
+				if (m_IsStopping && m_Tasks.empty())
+				{
+					return;
+				}
+			}
+
+			RunPendingTask();
+		}
+	}
+
+	bool ThreadPool::RunPendingTask()
+	{
+		std::packaged_task<void()> task;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Tasks.empty())
+			{
+				return false;
+			}
+
+			task = std::move(m_Tasks.front());
+			m_Tasks.pop_front();
+		}
+
+		task();
+
+		// Wake up threads that may be waiting on this task. Taking the lock first ensures a waiter cannot miss the signal between checking and sleeping.
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+		}
+		m_Condition.notify_all();
+		return true;
+	}
+}
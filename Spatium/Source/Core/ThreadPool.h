@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <algorithm>
+
+namespace Spatium
+{
+	// A fixed set of worker threads fed from a shared task queue. Threads waiting on a task run other queued tasks in the meantime,
+	// which allows tasks to submit and wait on subtasks of their own (such as both halves of a recursive build) without deadlocking.
+	class ThreadPool
+	{
+	public:
+		ThreadPool(uint32_t threadCount); // Includes the calling thread, which participates whenever it waits.
+		~ThreadPool();
+
+		template <typename Function>
+		std::future<void> Submit(Function task);
+		void Wait(std::future<void>& taskFuture);
+
+		template <typename Function>
+		void ParallelFor(size_t beginIndex, size_t endIndex, size_t grainSize, Function rangeFunction); // Calls rangeFunction(begin, end) over chunks of at most grainSize.
+
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Workers.size()) + 1; }
+
+	private:
+		void WorkerLoop();
+		bool RunPendingTask();
+
+	private:
+		std::vector<std::thread> m_Workers;
+		std::deque<std::packaged_task<void()>> m_Tasks;
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition; // Signalled whenever a task is queued or finishes.
+		bool m_IsStopping = false;
+	};
+
+	template <typename Function>
+	std::future<void> ThreadPool::Submit(Function task)
+	{
+		std::packaged_task<void()> packagedTask(std::move(task));
+		std::future<void> taskFuture = packagedTask.get_future();
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Tasks.push_back(std::move(packagedTask));
+		}
+
+		m_Condition.notify_all();
+		return taskFuture;
+	}
+
+	template <typename Function>
+	void ThreadPool::ParallelFor(size_t beginIndex, size_t endIndex, size_t grainSize, Function rangeFunction)
+	{
+		grainSize = std::max<size_t>(grainSize, 1);
+
+		// Queue every chunk but the first, which the calling thread runs itself.
+		std::vector<std::future<void>> chunkFutures;
+		for (size_t chunkBegin = beginIndex + grainSize; chunkBegin < endIndex; chunkBegin += grainSize)
+		{
+			size_t chunkEnd = std::min(chunkBegin + grainSize, endIndex);
+			chunkFutures.push_back(Submit([&rangeFunction, chunkBegin, chunkEnd]()
+			{
+				rangeFunction(chunkBegin, chunkEnd);
+			}));
+		}
+
+		if (beginIndex < endIndex)
+		{
+			rangeFunction(beginIndex, std::min(beginIndex + grainSize, endIndex));
+		}
+
+		for (std::future<void>& chunkFuture : chunkFutures)
+		{
+			Wait(chunkFuture);
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace Spatium
+{
+	// A stack for tree traversals that lives on the call stack for typical tree depths and only falls back to the heap for very deep trees.
+	template <typename Type, size_t InlineCapacity = 64>
+	class TraversalStack
+	{
+	public:
+		void Push(const Type& value)
+		{
+			if (m_Size < InlineCapacity)
+			{
+				m_InlineValues[m_Size] = value;
+			}
+			else
+			{
+				m_OverflowValues.push_back(value);
+			}
+
+			m_Size++;
+		}
+
+		Type Pop()
+		{
+			m_Size--;
+			if (m_Size < InlineCapacity)
+			{
+				return m_InlineValues[m_Size];
+			}
+
+			Type value = m_OverflowValues.back();
+			m_OverflowValues.pop_back();
+			return value;
+		}
+
+		bool IsEmpty() const { return m_Size == 0; }
+		size_t GetSize() const { return m_Size; }
+
+	private:
+		Type m_InlineValues[InlineCapacity];
+		std::vector<Type> m_OverflowValues;
+		size_t m_Size = 0;
+	};
+}
@@ -1,4 +1,5 @@
 #include "BVH/BVH.hpp"
+#include "BVH/TriangleBVH.h"
 #include "Core/Stopwatch.h"
 
 #include <GLM/gtc/matrix_transform.hpp>
@@ -22,8 +23,6 @@
      // BVH information
      struct
      {
-         Object* m_Next = nullptr; // Next object in the BVH node.
-         Object* m_Previous = nullptr; // Previous object in the BVH node.
          BVHNode* m_Node = nullptr; // The node it belongs to.
      } m_BVHInfo;
  };
@@ -55,6 +54,15 @@ int main()
         std::cout << "Tree Depth: " << objectBVH.GetDepth() << "\n";
     }
 
+    objectBVH.Clear();
+    {
+        Spatium::Stopwatch stopWatch("Top-Down Binned SAH Build Took");
+        Spatium::BVHBuildConfiguration binnedConfiguration = buildConfiguration;
+        binnedConfiguration.m_TopDownStrategy = Spatium::BVHTopDownStrategy::BinnedSAH;
+        objectBVH.BuildTopDown(objectPtrs.begin(), objectPtrs.end(), binnedConfiguration);
+        std::cout << "Tree Depth: " << objectBVH.GetDepth() << "\n";
+    }
+
     objectBVH.Clear();
     {
         Spatium::Stopwatch stopWatch("Bottom-Up Build Took");
@@ -62,12 +70,29 @@ int main()
         std::cout << "Tree Depth: " << objectBVH.GetDepth() << "\n";
     }
 
+    objectBVH.Clear();
+    {
+        Spatium::Stopwatch stopWatch("Linear Build Took");
+        objectBVH.BuildLinear(objectPtrs.begin(), objectPtrs.end(), buildConfiguration);
+        std::cout << "Tree Depth: " << objectBVH.GetDepth() << "\n";
+    }
+
     objectBVH.Clear();
     {
         Spatium::Stopwatch stopWatch("Dynamic Insertion Took");
         objectBVH.Insert(objectPtrs.begin(), objectPtrs.end(), buildConfiguration);
         std::cout << "Tree Depth: " << objectBVH.GetDepth() << "\n";
     }
+
+    // Duplicated faces (common in scanned meshes) can't be separated by any split and must end up in a single leaf.
+    {
+        Spatium::Stopwatch stopWatch("Coincident Triangle Build Took");
+        std::vector<Spatium::Triangle> coincidentTriangles(5, Spatium::Triangle(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+        Spatium::TriangleBVH triangleBVH;
+        triangleBVH.Build(coincidentTriangles, Spatium::TriangleBVHConfiguration());
+        std::cout << "Node Count: " << triangleBVH.GetNodes().size() << ", Reference Count: " << triangleBVH.GetIndices().size() << "\n";
+    }
 }
 
 void GenerateDummyObjects(std::vector<std::shared_ptr<Object>>& sceneObjects)